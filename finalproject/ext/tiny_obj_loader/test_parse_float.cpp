@@ -0,0 +1,185 @@
+//
+// Checks tryParseFloat against strtof, which rounds correctly, on random
+// float bit patterns, exact ties between two floats, mantissas longer than
+// the 19 digits the fast path keeps, and denormals. Every string strtof reads
+// completely must give the same bits, and the others must be rejected.
+//
+// Build with the test_parse_float target and run it, or through ctest. It
+// prints the first mismatches and returns non-zero if there are any.
+//
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+
+// tryParseFloat is static, so the loader is compiled into this file.
+#include "tiny_obj_loader.cpp"
+
+namespace {
+
+std::mt19937_64 rng(20161017);
+long num_checked = 0;
+long num_failed = 0;
+
+void report(const std::string &s, const char *what) {
+  if (num_failed < 20) {
+    printf("FAIL \"%s\": %s\n", s.c_str(), what);
+  }
+  num_failed++;
+}
+
+void check(const std::string &s) {
+  num_checked++;
+  float f = 0.0f;
+  bool ok = tinyobj::tryParseFloat(s.data(), s.data() + s.size(), &f);
+
+  // an exponent without digits is only a prefix of a number to strtof
+  char *end;
+  float expected = strtof(s.c_str(), &end);
+  if (end == s.c_str() || static_cast<size_t>(end - s.c_str()) != s.size()) {
+    if (ok) {
+      report(s, "accepted, strtof does not read all of it");
+    }
+    return;
+  }
+  if (!ok) {
+    report(s, "rejected, strtof accepts it");
+    return;
+  }
+  unsigned int got_bits, expected_bits;
+  memcpy(&got_bits, &f, sizeof(got_bits));
+  memcpy(&expected_bits, &expected, sizeof(expected_bits));
+  if (got_bits != expected_bits) {
+    char what[128];
+    snprintf(what, sizeof(what), "got %.9g (0x%08x), strtof gives %.9g (0x%08x)",
+             f, got_bits, expected, expected_bits);
+    report(s, what);
+  }
+}
+
+float random_float(unsigned int lowest, unsigned int highest) {
+  unsigned int bits = lowest + static_cast<unsigned int>(
+                                   rng() % (highest - lowest + 1ull));
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return (rng() & 1) ? -f : f;
+}
+
+std::string format(const char *fmt, int precision, double d) {
+  char buf[512];
+  snprintf(buf, sizeof(buf), fmt, precision, d);
+  return buf;
+}
+
+// Finite floats printed the ways an exporter might print them.
+void check_random_bits() {
+  for (int i = 0; i < 500000; i++) {
+    float f = random_float(0, 0x7F7FFFFFu);
+    check(format("%.*g", 9, f));
+    check(format("%.*g", 1 + static_cast<int>(rng() % 17), f));
+    check(format("%.*f", static_cast<int>(rng() % 10), f));
+  }
+}
+
+// The double halfway between two neighbouring floats, which strtof rounds
+// to the even one, written out exactly and then nudged above the tie by a
+// last digit far past the 19th.
+void check_ties() {
+  for (int i = 0; i < 200000; i++) {
+    float lo = std::fabs(random_float(0, 0x7F7FFFFEu));
+    float hi = std::nextafter(lo, INFINITY);
+    double tie = (static_cast<double>(lo) + static_cast<double>(hi)) / 2;
+    // 160 digits after the point hold the whole expansion of any tie
+    std::string exact = format("%.*e", 160, tie);
+    check(exact);
+    std::string above = exact;
+    size_t e = above.find('e');
+    above[e - 1] = '1';
+    check(above);
+    check("-" + exact);
+    check(format("%.*g", 17, tie));
+  }
+  // the ties the fast path sees after the last bit of a float
+  check("16777217");
+  check("16777219");
+  check("33554434");
+  check("9007199254740993");
+  check("1.00000005960464477539062500000001");
+}
+
+// Decimal strings of up to 40 digits with the point anywhere and an
+// exponent that keeps most of them in range.
+void check_long_mantissas() {
+  for (int i = 0; i < 500000; i++) {
+    std::string s = (rng() & 1) ? "-" : "";
+    int digits = 1 + static_cast<int>(rng() % 40);
+    for (int d = 0; d < digits; d++) {
+      // runs of zeros and nines are where rounding goes wrong
+      int kind = static_cast<int>(rng() % 4);
+      char c = kind == 0 ? '0' : kind == 1 ? '9' : char('0' + rng() % 10);
+      s += c;
+    }
+    if (rng() % 4 != 0) {
+      size_t begin = s[0] == '-' ? 1 : 0;
+      s.insert(begin + rng() % (s.size() - begin + 1), ".");
+    }
+    if (rng() % 2 == 0) {
+      s += (rng() & 1) ? "e" : "E";
+      int exponent = static_cast<int>(rng() % 121) - 60;
+      if (exponent >= 0 && (rng() & 1)) {
+        s += "+";
+      }
+      s += std::to_string(exponent);
+    }
+    check(s);
+  }
+}
+
+// Floats with a zero exponent field, from the smallest up to the largest,
+// and values below the smallest one.
+void check_denormals() {
+  for (int i = 0; i < 200000; i++) {
+    float f = random_float(1, 0x007FFFFFu);
+    check(format("%.*g", 9, f));
+    check(format("%.*e", static_cast<int>(rng() % 60), f));
+  }
+  check("1e-45");
+  check("1.4e-45");
+  check("7e-46");
+  check("7.006492321624085354618647916449580656401e-46");
+  check("1e-46");
+  check("1.17549421e-38");
+  check("1.17549435e-38");
+  check("0.000000000000000000000000000000000000000000001");
+}
+
+void check_special() {
+  const char *cases[] = {"0",        "-0",       "+1",         "1.",
+                         ".5",       "-.25",     "5.e3",       "0.1",
+                         "1e22",     "1e-22",    "1e23",       "3.4028235e38",
+                         "3.4028236e38", "1e39", "-1e39",      "1e100000000",
+                         "1e-100000000", "0e999999999",
+                         "123456789012345678901234567890",
+                         "",         "-",        "+",          ".",
+                         "-.",       "e5",       "1e",         "1e+",
+                         ".e1"};
+  for (const char *s : cases) {
+    check(s);
+  }
+}
+
+} // namespace
+
+int main() {
+  check_special();
+  check_random_bits();
+  check_ties();
+  check_long_mantissas();
+  check_denormals();
+  printf("%ld strings checked against strtof, %ld failed\n", num_checked,
+         num_failed);
+  return num_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
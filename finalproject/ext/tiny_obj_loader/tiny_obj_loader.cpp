@@ -6,11 +6,22 @@
 #include <cstddef>
 #include <cctype>
 
+#include <algorithm>
+#include <atomic>
 #include <string>
 #include <vector>
 #include <map>
 #include <fstream>
 #include <sstream>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TINYOBJ_USE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include "tiny_obj_loader.h"
 
@@ -27,17 +38,91 @@ struct vertex_index {
   vertex_index(int vidx, int vtidx, int vnidx)
       : v_idx(vidx), vt_idx(vtidx), vn_idx(vnidx){}
 };
-// for std::map
-static inline bool operator<(const vertex_index &a, const vertex_index &b) {
-  if (a.v_idx != b.v_idx)
-    return (a.v_idx < b.v_idx);
-  if (a.vn_idx != b.vn_idx)
-    return (a.vn_idx < b.vn_idx);
-  if (a.vt_idx != b.vt_idx)
-    return (a.vt_idx < b.vt_idx);
 
-  return false;
-}
+// Open addressing hash map from a v/vt/vn triple to its index in a shape,
+// with linear probing. The triple is the 96 bit key and is stored in the
+// slot, so there is no allocation per vertex. One table is reused for every
+// face group: reset() empties it and sizes it from the group's face count.
+class VertexCache {
+public:
+  VertexCache() : m_mask(0), m_size(0) {}
+
+  // Empty the table, with room for about `count` triples before it grows.
+  void reset(size_t count) {
+    size_t capacity = 16;
+    while (capacity < 2 * count) {
+      capacity *= 2;
+    }
+    m_slots.assign(capacity, Slot());
+    m_mask = capacity - 1;
+    m_size = 0;
+  }
+
+  // Returns true and points `index` at the index stored for `vi` if it is in
+  // the table. Otherwise `vi` is added and the caller must set its `index`.
+  bool lookup(const vertex_index &vi, unsigned int *&index) {
+    if (2 * (m_size + 1) > m_slots.size()) {
+      grow();
+    }
+    size_t i = hash(vi) & m_mask;
+    while (m_slots[i].index != EMPTY) {
+      const Slot &slot = m_slots[i];
+      if (slot.v_idx == vi.v_idx && slot.vt_idx == vi.vt_idx &&
+          slot.vn_idx == vi.vn_idx) {
+        index = &m_slots[i].index;
+        return true;
+      }
+      i = (i + 1) & m_mask;
+    }
+    m_slots[i].v_idx = vi.v_idx;
+    m_slots[i].vt_idx = vi.vt_idx;
+    m_slots[i].vn_idx = vi.vn_idx;
+    m_size++;
+    index = &m_slots[i].index;
+    return false;
+  }
+
+private:
+  static const unsigned int EMPTY = 0xffffffffu;
+
+  struct Slot {
+    int v_idx, vt_idx, vn_idx;
+    unsigned int index;
+    Slot() : v_idx(0), vt_idx(0), vn_idx(0), index(EMPTY) {}
+  };
+
+  static size_t hash(const vertex_index &vi) {
+    unsigned long long h =
+        (static_cast<unsigned long long>(static_cast<unsigned int>(vi.v_idx))
+         << 32) |
+        static_cast<unsigned int>(vi.vt_idx);
+    h = (h ^ static_cast<unsigned int>(vi.vn_idx)) * 0x9E3779B97F4A7C15ull;
+    return static_cast<size_t>(h ^ (h >> 29));
+  }
+
+  // Double the table, adding the old slots back in their new places.
+  void grow() {
+    std::vector<Slot> old;
+    old.swap(m_slots);
+    m_slots.assign(2 * old.size(), Slot());
+    m_mask = m_slots.size() - 1;
+    for (size_t j = 0; j < old.size(); j++) {
+      if (old[j].index == EMPTY) {
+        continue;
+      }
+      size_t i = hash(vertex_index(old[j].v_idx, old[j].vt_idx,
+                                   old[j].vn_idx)) & m_mask;
+      while (m_slots[i].index != EMPTY) {
+        i = (i + 1) & m_mask;
+      }
+      m_slots[i] = old[j];
+    }
+  }
+
+  std::vector<Slot> m_slots;
+  size_t m_mask;
+  size_t m_size;
+};
 
 struct obj_shape {
   std::vector<float> v;
@@ -75,7 +160,8 @@ static inline int parseInt(const char *&token) {
 }
 
 
-// Tries to parse a floating point number located at s.
+// Tries to parse a floating point number located at s, correctly rounded to
+// the nearest float.
 //
 // s_end should be a location in the string where reading should absolutely
 // stop. For example at the end of the string, to prevent buffer overflows.
@@ -85,13 +171,14 @@ static inline int parseInt(const char *&token) {
 //   END     = ? anything not in digit ?
 //   digit   = "0" | "1" | "2" | "3" | "4" | "5" | "6" | "7" | "8" | "9" ;
 //   integer = [sign] , digit , {digit} ;
-//   decimal = integer , ["." , integer] ;
+//   decimal = [sign] , ( digit , {digit} , ["." , {digit}]
+//                      | "." , digit , {digit} ) ;
 //   float   = ( decimal , END ) | ( decimal , ("E" | "e") , integer , END ) ;
 //
 //  Valid strings are for example:
-//   -0  +3.1417e+2  -0.0E-3  1.0324  -1.41   11e2
+//   -0  +3.1417e+2  -0.0E-3  1.0324  -1.41   11e2  .5
 //
-// If the parsing is a success, result is set to the parsed value and true 
+// If the parsing is a success, result is set to the parsed value and true
 // is returned.
 //
 // The function is greedy and will parse until any of the following happens:
@@ -101,132 +188,172 @@ static inline int parseInt(const char *&token) {
 // The following situations triggers a failure:
 //  - s >= s_end.
 //  - parse failure.
-// 
-static bool tryParseDouble(const char *s, const char *s_end, double *result)
-{
-    if (s >= s_end)
-    {
-        return false;
+//
+// Up to 19 significant digits are read into an integer, eight at a time
+// when eight digits follow. If that integer and the power of ten are both
+// exact doubles, one multiply or divide rounds correctly (Clinger's fast
+// path), and rounding that double to float is exact too unless it lands on
+// a tie between two floats. Everything else, which an OBJ file almost never
+// has, goes to strtof with the decimal point taken out so that the locale
+// does not matter.
+//
+
+// The 64 bit little endian word at p holds eight ASCII digits.
+static inline bool isEightDigits(unsigned long long v) {
+  return (((v & 0xF0F0F0F0F0F0F0F0ull) |
+           (((v + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) ==
+          0x3333333333333333ull);
+}
+
+// The value of eight ASCII digits in a little endian word, with three
+// multiplies instead of eight.
+static inline unsigned int parseEightDigits(unsigned long long v) {
+  const unsigned long long mask = 0x000000FF000000FFull;
+  const unsigned long long mul1 = 0x000F424000000064ull; // 100 + (1000000 << 32)
+  const unsigned long long mul2 = 0x0000271000000001ull; // 1 + (10000 << 32)
+  v -= 0x3030303030303030ull;
+  v = (v * 10) + (v >> 8);
+  v = (((v & mask) * mul1) + (((v >> 16) & mask) * mul2)) >> 32;
+  return static_cast<unsigned int>(v);
+}
+
+// Adds the digits from p on to mantissa while it has fewer than 19
+// significant digits and counts the ones after that in dropped. `inexact`
+// is set if any of the dropped digits is not a zero. Returns the end of the
+// digits.
+static const char *accumulateDigits(const char *p, const char *s_end,
+                                    unsigned long long &mantissa,
+                                    int &significant, int &dropped,
+                                    bool &inexact) {
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+  while (s_end - p >= 8 && significant + 8 <= 19) {
+    unsigned long long v;
+    memcpy(&v, p, sizeof(v));
+    if (!isEightDigits(v)) {
+      break;
+    }
+    mantissa = mantissa * 100000000ull + parseEightDigits(v);
+    if (mantissa != 0) {
+      significant += 8;
     }
+    p += 8;
+  }
+#endif
+  for (; p != s_end && isdigit(*p); p++) {
+    if (significant < 19) {
+      mantissa = mantissa * 10 + static_cast<unsigned int>(*p - '0');
+      if (mantissa != 0) {
+        significant++;
+      }
+    } else {
+      dropped++;
+      inexact |= (*p != '0');
+    }
+  }
+  return p;
+}
 
-    double mantissa = 0.0;
-    // This exponent is base 2 rather than 10.
-    // However the exponent we parse is supposed to be one of ten,
-    // thus we must take care to convert the exponent/and or the 
-    // mantissa to a * 2^E, where a is the mantissa and E is the
-    // exponent.
-    // To get the final double we will use ldexp, it requires the
-    // exponent to be in base 2.
-    int exponent = 0;
-
-    // NOTE: THESE MUST BE DECLARED HERE SINCE WE ARE NOT ALLOWED
-    // TO JUMP OVER DEFINITIONS.
-    char sign = '+';
-    char exp_sign = '+';
-    char const *curr = s;
-
-    // How many characters were read in a loop. 
-    int read = 0;
-    // Tells whether a loop terminated due to reaching s_end.
-    bool end_not_reached = false;
-
-    /*
-        BEGIN PARSING.
-    */
-
-    // Find out what sign we've got.
-    if (*curr == '+' || *curr == '-')
-    {
-        sign = *curr;
-        curr++;
-    }
-    else if (isdigit(*curr)) { /* Pass through. */ }
-    else
-    {
-        goto fail;
-    }
-
-    // Read the integer part.
-    while ((end_not_reached = (curr != s_end)) && isdigit(*curr))
-    {
-        mantissa *= 10;
-        mantissa += static_cast<int>(*curr - 0x30);
-        curr++; read++;
-    }
-
-    // We must make sure we actually got something.
-    if (read == 0)
-        goto fail;
-    // We allow numbers of form "#", "###" etc.
-    if (!end_not_reached)
-        goto assemble;
-
-    // Read the decimal part.
-    if (*curr == '.')
-    {
-        curr++;
-        read = 1;
-        while ((end_not_reached = (curr != s_end)) && isdigit(*curr))
-        {
-            // NOTE: Don't use powf here, it will absolutely murder precision.
-            mantissa += static_cast<int>(*curr - 0x30) * pow(10.0, -read);
-            read++; curr++;
-        }
-    }
-    else if (*curr == 'e' || *curr == 'E') {}
-    else
-    {
-        goto assemble;
-    }
-
-    if (!end_not_reached)
-        goto assemble;
-
-    // Read the exponent part.
-    if (*curr == 'e' || *curr == 'E')
-    {
-        curr++;
-        // Figure out if a sign is present and if it is.
-        if ((end_not_reached = (curr != s_end)) && (*curr == '+' || *curr == '-'))
-        {
-            exp_sign = *curr;
-            curr++;
-        }
-        else if (isdigit(*curr)) { /* Pass through. */ }
-        else
-        {
-            // Empty E is not allowed.
-            goto fail;
-        }
-
-        read = 0;
-        while ((end_not_reached = (curr != s_end)) && isdigit(*curr))
-        {
-            exponent *= 10;
-            exponent += static_cast<int>(*curr - 0x30);
-            curr++; read++;
-        }
-        exponent *= (exp_sign == '+'? 1 : -1);
-        if (read == 0)
-            goto fail;
-    }
-
-assemble:
-    *result = (sign == '+'? 1 : -1) * ldexp(mantissa * pow(5.0, exponent), exponent);
-    return true;
-fail:
+static bool tryParseFloat(const char *s, const char *s_end, float *result) {
+  // exact powers of ten as doubles
+  static const double powers[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                  1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                  1e18, 1e19, 1e20, 1e21, 1e22};
+
+  if (s >= s_end) {
     return false;
+  }
+
+  const char *curr = s;
+  bool negative = false;
+  if (*curr == '+' || *curr == '-') {
+    negative = (*curr == '-');
+    curr++;
+  }
+
+  unsigned long long mantissa = 0;
+  int significant = 0, dropped = 0;
+  bool inexact = false;
+
+  // Read the integer part, digits past the 19th scale it up.
+  const char *intBegin = curr;
+  curr = accumulateDigits(curr, s_end, mantissa, significant, dropped,
+                          inexact);
+  const char *intEnd = curr;
+  int exponent = dropped;
+
+  // Read the decimal part, digits past the 19th are left out.
+  const char *fracBegin = curr, *fracEnd = curr;
+  if (curr != s_end && *curr == '.') {
+    fracBegin = ++curr;
+    dropped = 0;
+    curr = accumulateDigits(curr, s_end, mantissa, significant, dropped,
+                            inexact);
+    fracEnd = curr;
+    exponent -= static_cast<int>(fracEnd - fracBegin) - dropped;
+  }
+
+  // We must make sure we actually got something.
+  if (intBegin == intEnd && fracBegin == fracEnd) {
+    return false;
+  }
+
+  // Read the exponent part.
+  int exp10 = 0;
+  if (curr != s_end && (*curr == 'e' || *curr == 'E')) {
+    curr++;
+    bool expNegative = false;
+    if (curr != s_end && (*curr == '+' || *curr == '-')) {
+      expNegative = (*curr == '-');
+      curr++;
+    }
+    // Empty E is not allowed.
+    if (curr == s_end || !isdigit(*curr)) {
+      return false;
+    }
+    for (; curr != s_end && isdigit(*curr); curr++) {
+      if (exp10 < 100000) {
+        exp10 = exp10 * 10 + (*curr - '0');
+      }
+    }
+    if (expNegative) {
+      exp10 = -exp10;
+    }
+  }
+  exponent += exp10;
+
+  if (!inexact && mantissa <= (1ull << 53) && exponent >= -22 &&
+      exponent <= 22) {
+    double d = static_cast<double>(mantissa);
+    d = exponent < 0 ? d / powers[-exponent] : d * powers[exponent];
+    // The 29 bits a double has beyond a float are exactly half of the last
+    // float bit on a tie. Every value on this path is a normal float.
+    unsigned long long bits;
+    memcpy(&bits, &d, sizeof(bits));
+    if ((bits & 0x1FFFFFFFull) != 0x10000000ull) {
+      float f = static_cast<float>(d);
+      *result = negative ? -f : f;
+      return true;
+    }
+  }
+
+  std::string digits(negative ? "-" : "");
+  digits.append(intBegin, intEnd);
+  digits.append(fracBegin, fracEnd);
+  digits += 'e';
+  digits += std::to_string(exp10 - static_cast<int>(fracEnd - fracBegin));
+  *result = strtof(digits.c_str(), NULL);
+  return true;
 }
 static inline float parseFloat(const char *&token) {
   token += strspn(token, " \t");
 #ifdef TINY_OBJ_LOADER_OLD_FLOAT_PARSER
-  float f = (float)atof(token);
-  token += strcspn(token, " \t\r");
+  float f = isNewLine(token[0]) ? 0.0f : (float)atof(token);
+  token += strcspn(token, " \t\r\n");
 #else
-  const char *end = token + strcspn(token, " \t\r");
-  double val = 0.0;
-  tryParseDouble(token, end, &val);
-  float f = static_cast<float>(val);
+  const char *end = token + strcspn(token, " \t\r\n");
+  float f = 0.0f;
+  tryParseFloat(token, end, &f);
   token = end;
 #endif
   return f;
@@ -245,13 +372,29 @@ static inline void parseFloat3(float &x, float &y, float &z,
   z = parseFloat(token);
 }
 
+// atoi that does not skip past the end of the line, so that it can run on a
+// whole file, and does not go through strtol.
+static inline int parseIndex(const char *token) {
+  token += strspn(token, " \t\v\f\r");
+  bool negative = false;
+  if (*token == '+' || *token == '-') {
+    negative = (*token == '-');
+    token++;
+  }
+  unsigned int i = 0;
+  for (; isdigit(*token); token++) {
+    i = i * 10 + static_cast<unsigned int>(*token - '0');
+  }
+  return static_cast<int>(negative ? 0u - i : i);
+}
+
 // Parse triples: i, i/j/k, i//k, i/j
 static vertex_index parseTriple(const char *&token, int vsize, int vnsize,
                                 int vtsize) {
   vertex_index vi(-1);
 
-  vi.v_idx = fixIndex(atoi(token), vsize);
-  token += strcspn(token, "/ \t\r");
+  vi.v_idx = fixIndex(parseIndex(token), vsize);
+  token += strcspn(token, "/ \t\r\n");
   if (token[0] != '/') {
     return vi;
   }
@@ -260,37 +403,36 @@ static vertex_index parseTriple(const char *&token, int vsize, int vnsize,
   // i//k
   if (token[0] == '/') {
     token++;
-    vi.vn_idx = fixIndex(atoi(token), vnsize);
-    token += strcspn(token, "/ \t\r");
+    vi.vn_idx = fixIndex(parseIndex(token), vnsize);
+    token += strcspn(token, "/ \t\r\n");
     return vi;
   }
 
   // i/j/k or i/j
-  vi.vt_idx = fixIndex(atoi(token), vtsize);
-  token += strcspn(token, "/ \t\r");
+  vi.vt_idx = fixIndex(parseIndex(token), vtsize);
+  token += strcspn(token, "/ \t\r\n");
   if (token[0] != '/') {
     return vi;
   }
 
   // i/j/k
   token++; // skip '/'
-  vi.vn_idx = fixIndex(atoi(token), vnsize);
-  token += strcspn(token, "/ \t\r");
+  vi.vn_idx = fixIndex(parseIndex(token), vnsize);
+  token += strcspn(token, "/ \t\r\n");
   return vi;
 }
 
 static unsigned int
-updateVertex(std::map<vertex_index, unsigned int> &vertexCache,
+updateVertex(VertexCache &vertexCache,
              std::vector<float> &positions, std::vector<float> &normals,
              std::vector<float> &texcoords,
              const std::vector<float> &in_positions,
              const std::vector<float> &in_normals,
              const std::vector<float> &in_texcoords, const vertex_index &i) {
-  const std::map<vertex_index, unsigned int>::iterator it = vertexCache.find(i);
-
-  if (it != vertexCache.end()) {
+  unsigned int *cached;
+  if (vertexCache.lookup(i, cached)) {
     // found cache
-    return it->second;
+    return *cached;
   }
 
   assert(in_positions.size() > static_cast<unsigned int>(3 * i.v_idx + 2));
@@ -311,7 +453,7 @@ updateVertex(std::map<vertex_index, unsigned int> &vertexCache,
   }
 
   unsigned int idx = static_cast<unsigned int>(positions.size() / 3 - 1);
-  vertexCache[i] = idx;
+  *cached = idx;
 
   return idx;
 }
@@ -340,16 +482,20 @@ static void InitMaterial(material_t &material) {
 }
 
 static bool exportFaceGroupToShape(
-    shape_t &shape, std::map<vertex_index, unsigned int> vertexCache,
+    shape_t &shape, VertexCache &vertexCache,
     const std::vector<float> &in_positions,
     const std::vector<float> &in_normals,
     const std::vector<float> &in_texcoords,
     const std::vector<std::vector<vertex_index> > &faceGroup,
-    const int material_id, const std::string &name, bool clearCache) {
+    const int material_id, const std::string &name) {
   if (faceGroup.empty()) {
     return false;
   }
 
+  // Vertices are only shared within a group. A triangle mesh has around one
+  // unique vertex for every two faces.
+  vertexCache.reset(faceGroup.size() / 2);
+
   // Flatten vertices and indices
   for (size_t i = 0; i < faceGroup.size(); i++) {
     const std::vector<vertex_index> &face = faceGroup[i];
@@ -385,9 +531,6 @@ static bool exportFaceGroupToShape(
 
   shape.name = name;
 
-  if (clearCache)
-    vertexCache.clear();
-
   return true;
 }
 
@@ -620,6 +763,97 @@ void LoadMtl(std::map<std::string, int> &material_map,
   materials.push_back(material);
 }
 
+// A whole file, memory mapped where the platform allows it and read into a
+// buffer otherwise. The bytes are not '\0' terminated.
+class MappedFile {
+public:
+  MappedFile() : m_data(NULL), m_size(0), m_map(NULL) {}
+  ~MappedFile() {
+#ifdef TINYOBJ_USE_MMAP
+    if (m_map) {
+      munmap(m_map, m_size);
+    }
+#endif
+  }
+
+  bool open(const char *filename) {
+#ifdef TINYOBJ_USE_MMAP
+    int fd = ::open(filename, O_RDONLY);
+    if (fd < 0) {
+      return false;
+    }
+    struct stat sb;
+    if (fstat(fd, &sb) == 0 && S_ISREG(sb.st_mode) && sb.st_size > 0) {
+      void *map = mmap(NULL, static_cast<size_t>(sb.st_size), PROT_READ,
+                       MAP_PRIVATE, fd, 0);
+      if (map != MAP_FAILED) {
+        // the parser reads the file front to back
+        madvise(map, static_cast<size_t>(sb.st_size), MADV_SEQUENTIAL);
+        m_map = map;
+        m_size = static_cast<size_t>(sb.st_size);
+        m_data = static_cast<const char *>(map);
+        close(fd);
+        return true;
+      }
+    }
+    close(fd);
+#endif
+    std::ifstream ifs(filename, std::ios::binary);
+    if (!ifs) {
+      return false;
+    }
+    std::stringstream ss;
+    ss << ifs.rdbuf();
+    m_buffer = ss.str();
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+    return true;
+  }
+
+  const char *data() const { return m_data; }
+  size_t size() const { return m_size; }
+
+  // Drop the pages of [begin, end) once they have been parsed. They are still
+  // in the page cache, but no longer count towards the process' memory.
+  void release(const char *begin, const char *end) const {
+#ifdef TINYOBJ_USE_MMAP
+    if (!m_map) {
+      return;
+    }
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t first = (static_cast<size_t>(begin - m_data) + page - 1) / page * page;
+    size_t last = static_cast<size_t>(end - m_data) / page * page;
+    if (end == m_data + m_size) {
+      last = first < m_size ? m_size : first;
+    }
+    if (first < last) {
+      madvise(static_cast<char *>(m_map) + first, last - first, MADV_DONTNEED);
+    }
+#else
+    (void)begin;
+    (void)end;
+#endif
+  }
+
+private:
+  MappedFile(const MappedFile &);
+  MappedFile &operator=(const MappedFile &);
+
+  const char *m_data;
+  size_t m_size;
+  void *m_map;
+  std::string m_buffer; // when the file could not be mapped
+};
+
+// Reads a block of memory as a std::istream without copying it.
+class MemoryStreamBuf : public std::streambuf {
+public:
+  MemoryStreamBuf(const char *data, size_t size) {
+    char *p = const_cast<char *>(data);
+    setg(p, p, p + size);
+  }
+};
+
 bool MaterialFileReader::operator()(const std::string &matId,
                                     std::vector<material_t> &materials,
                                     std::map<std::string, int> &matMap,
@@ -632,9 +866,13 @@ bool MaterialFileReader::operator()(const std::string &matId,
     filepath = matId;
   }
 
-  std::ifstream matIStream(filepath.c_str());
+  // read straight out of the mapped file, or out of nothing if it is missing
+  MappedFile file;
+  bool found = file.open(filepath.c_str());
+  MemoryStreamBuf matBuf(file.data(), file.size());
+  std::istream matIStream(&matBuf);
   LoadMtl(matMap, materials, matIStream);
-  if (!matIStream) {
+  if (!found) {
     std::stringstream ss;
     ss << "WARN: Material file [ " << filepath << " ] not found. Created a default material.";
     err += ss.str();
@@ -647,24 +885,154 @@ bool LoadObj(std::vector<shape_t> &shapes, // [output]
              std::string &err,
              const char *filename, const char *mtl_basepath) {
 
-  shapes.clear();
+  // the chunked loader on one thread, parsing the mapped file in place
+  return LoadObjParallel(shapes, materials, err, filename, mtl_basepath, 1);
+}
 
-  std::stringstream errss;
+// Everything the group commands (usemtl, mtllib, g and o) read and update.
+struct obj_group_state {
+  std::vector<std::vector<vertex_index> > faceGroup;
+  std::string name;
+  std::map<std::string, int> material_map;
+  VertexCache vertexCache;
+  int material;
+  shape_t shape;
 
-  std::ifstream ifs(filename);
-  if (!ifs) {
-    errss << "Cannot open file [" << filename << "]" << std::endl;
-    err = errss.str();
-    return false;
+  obj_group_state() : material(-1) {}
+};
+
+// Export the current face group as a shape and start a new one.
+static void flushFaceGroup(obj_group_state &state,
+                           std::vector<shape_t> &shapes,
+                           const std::vector<float> &v,
+                           const std::vector<float> &vn,
+                           const std::vector<float> &vt) {
+  bool ret = exportFaceGroupToShape(state.shape, state.vertexCache, v, vn, vt,
+                                    state.faceGroup, state.material,
+                                    state.name);
+  if (ret) {
+    shapes.push_back(state.shape);
   }
+  state.shape = shape_t();
+  state.faceGroup.clear();
+}
 
-  std::string basePath;
-  if (mtl_basepath) {
-    basePath = mtl_basepath;
+// Handles `token` if it is a group command. Returns false if it is not one.
+// `ok` is cleared when the material library could not be read.
+static bool parseGroupCommand(const char *token, obj_group_state &state,
+                              std::vector<shape_t> &shapes,
+                              std::vector<material_t> &materials,
+                              std::string &err, MaterialReader &readMatFn,
+                              const std::vector<float> &v,
+                              const std::vector<float> &vn,
+                              const std::vector<float> &vt, bool &ok) {
+  ok = true;
+
+  // use mtl
+  if ((0 == strncmp(token, "usemtl", 6)) && isSpace((token[6]))) {
+
+    char namebuf[TINYOBJ_SSCANF_BUFFER_SIZE];
+    token += 7;
+#ifdef _MSC_VER
+    sscanf_s(token, "%s", namebuf, (unsigned)_countof(namebuf));
+#else
+    sscanf(token, "%s", namebuf);
+#endif
+
+    // Create face group per material.
+    flushFaceGroup(state, shapes, v, vn, vt);
+
+    if (state.material_map.find(namebuf) != state.material_map.end()) {
+      state.material = state.material_map[namebuf];
+    } else {
+      // { error!! material not found }
+      state.material = -1;
+    }
+
+    return true;
   }
-  MaterialFileReader matFileReader(basePath);
 
-  return LoadObj(shapes, materials, err, ifs, matFileReader);
+  // load mtl
+  if ((0 == strncmp(token, "mtllib", 6)) && isSpace((token[6]))) {
+    char namebuf[TINYOBJ_SSCANF_BUFFER_SIZE];
+    token += 7;
+#ifdef _MSC_VER
+    sscanf_s(token, "%s", namebuf, (unsigned)_countof(namebuf));
+#else
+    sscanf(token, "%s", namebuf);
+#endif
+
+    std::string err_mtl;
+    ok = readMatFn(namebuf, materials, state.material_map, err_mtl);
+    err += err_mtl;
+
+    if (!ok) {
+      state.faceGroup.clear(); // for safety
+    }
+
+    return true;
+  }
+
+  // group name
+  if (token[0] == 'g' && isSpace((token[1]))) {
+
+    // flush previous face group.
+    // material = -1;
+    flushFaceGroup(state, shapes, v, vn, vt);
+
+    std::vector<std::string> names;
+    while (!isNewLine(token[0])) {
+      std::string str = parseString(token);
+      names.push_back(str);
+      token += strspn(token, " \t\r"); // skip tag
+    }
+
+    assert(names.size() > 0);
+
+    // names[0] must be 'g', so skip the 0th element.
+    if (names.size() > 1) {
+      state.name = names[1];
+    } else {
+      state.name = "";
+    }
+
+    return true;
+  }
+
+  // object name
+  if (token[0] == 'o' && isSpace((token[1]))) {
+
+    // flush previous face group.
+    // material = -1;
+    flushFaceGroup(state, shapes, v, vn, vt);
+
+    // @todo { multiple object name? }
+    char namebuf[TINYOBJ_SSCANF_BUFFER_SIZE];
+    token += 2;
+#ifdef _MSC_VER
+    sscanf_s(token, "%s", namebuf, (unsigned)_countof(namebuf));
+#else
+    sscanf(token, "%s", namebuf);
+#endif
+    state.name = std::string(namebuf);
+
+    return true;
+  }
+
+  return false;
+}
+
+// Parse the vertices of a face record, `token` points past the 'f'.
+static void parseFace(const char *token, int vsize, int vnsize, int vtsize,
+                      std::vector<vertex_index> &face) {
+  token += strspn(token, " \t");
+
+  while (!isNewLine(token[0])) {
+    vertex_index vi = parseTriple(token, vsize, vnsize, vtsize);
+    face.push_back(vi);
+    size_t n = strspn(token, " \t\r");
+    token += n;
+  }
 }
 
 bool LoadObj(std::vector<shape_t> &shapes, // [output]
@@ -676,15 +1044,7 @@ bool LoadObj(std::vector<shape_t> &shapes, // [output]
   std::vector<float> v;
   std::vector<float> vn;
   std::vector<float> vt;
-  std::vector<std::vector<vertex_index> > faceGroup;
-  std::string name;
-
-  // material
-  std::map<std::string, int> material_map;
-  std::map<vertex_index, unsigned int> vertexCache;
-  int material = -1;
-
-  shape_t shape;
+  obj_group_state state;
 
   int maxchars = 8192;             // Alloc enough size.
   std::vector<char> buf(static_cast<size_t>(maxchars)); // Alloc enough size.
@@ -753,148 +1113,336 @@ bool LoadObj(std::vector<shape_t> &shapes, // [output]
 
     // face
     if (token[0] == 'f' && isSpace((token[1]))) {
-      token += 2;
-      token += strspn(token, " \t");
-
       std::vector<vertex_index> face;
-      while (!isNewLine(token[0])) {
-        vertex_index vi =
-            parseTriple(token, static_cast<int>(v.size() / 3), static_cast<int>(vn.size() / 3), static_cast<int>(vt.size() / 2));
-        face.push_back(vi);
-        size_t n = strspn(token, " \t\r");
-        token += n;
-      }
+      parseFace(token + 2, static_cast<int>(v.size() / 3),
+                static_cast<int>(vn.size() / 3),
+                static_cast<int>(vt.size() / 2), face);
 
-      faceGroup.push_back(face);
+      state.faceGroup.push_back(face);
 
       continue;
     }
 
-    // use mtl
-    if ((0 == strncmp(token, "usemtl", 6)) && isSpace((token[6]))) {
+    bool ok;
+    if (parseGroupCommand(token, state, shapes, materials, err, readMatFn, v,
+                          vn, vt, ok)) {
+      if (!ok) {
+        return false;
+      }
+      continue;
+    }
 
-      char namebuf[TINYOBJ_SSCANF_BUFFER_SIZE];
-      token += 7;
-#ifdef _MSC_VER
-      sscanf_s(token, "%s", namebuf, (unsigned)_countof(namebuf));
-#else
-      sscanf(token, "%s", namebuf);
-#endif
+    // Ignore unknown command.
+  }
 
-      // Create face group per material.
-      bool ret = exportFaceGroupToShape(shape, vertexCache, v, vn, vt,
-                                        faceGroup, material, name, true);
-      if (ret) {
-          shapes.push_back(shape);
-      }
-      shape = shape_t();
-      faceGroup.clear();
-
-      if (material_map.find(namebuf) != material_map.end()) {
-        material = material_map[namebuf];
-      } else {
-        // { error!! material not found }
-        material = -1;
-      }
+  flushFaceGroup(state, shapes, v, vn, vt); // for safety
 
+  err += errss.str();
+  return true;
+}
+
+// A face record found by the first pass, with how many v/vn/vt records came
+// before it in its chunk. Relative indices can only be resolved once the
+// counts of the earlier chunks are known.
+struct obj_face_line {
+  const char *line;
+  int v, vn, vt;
+};
+
+// A group command and how many faces of its chunk came before it.
+struct obj_command_line {
+  std::string line;
+  size_t faces;
+};
+
+// One line aligned piece of the file and everything parsed from it.
+struct obj_chunk {
+  const char *begin, *end;
+  std::vector<float> v, vn, vt;
+  std::vector<obj_face_line> faceLines;
+  std::vector<obj_command_line> commands;
+  std::vector<vertex_index> faceVerts; // every face, one after another
+  std::vector<size_t> faceSizes;
+  size_t vOffset, vnOffset, vtOffset; // counts in all earlier chunks
+};
+
+// Point `line` at the line at `p` and return where the next one starts.
+// Lines ending in '\n' are parsed in place, the parse helpers stop at it. A
+// last line without one is copied to `linebuf` so that it ends in '\0'.
+static const char *nextLine(const char *p, const char *end,
+                            std::string &linebuf, const char *&line) {
+  const char *eol =
+      static_cast<const char *>(memchr(p, '\n', static_cast<size_t>(end - p)));
+  if (eol) {
+    line = p;
+    return eol + 1;
+  }
+  linebuf.assign(p, end);
+  line = linebuf.c_str();
+  return end;
+}
+
+// Copy the line at `p` the way the serial loader's getline sees it, without
+// the '\n' or '\r\n'. Returns where the next line starts.
+static const char *copyLine(const char *p, const char *end,
+                            std::string &linebuf) {
+  const char *eol =
+      static_cast<const char *>(memchr(p, '\n', static_cast<size_t>(end - p)));
+  if (!eol) {
+    eol = end;
+  }
+  linebuf.assign(p, eol);
+  if (!linebuf.empty() && linebuf[linebuf.size() - 1] == '\r') {
+    linebuf.erase(linebuf.size() - 1);
+  }
+  return eol == end ? end : eol + 1;
+}
+
+// First pass over a chunk: parse the v/vn/vt records and note where the
+// faces and group commands are.
+static void scanChunk(obj_chunk &chunk) {
+  std::string linebuf;
+  for (const char *p = chunk.begin; p < chunk.end;) {
+    const char *line = p;
+    const char *token;
+    p = nextLine(p, chunk.end, linebuf, token);
+
+    // Skip leading space.
+    token += strspn(token, " \t");
+
+    if (isNewLine(token[0]) || token[0] == '#')
+      continue; // empty or comment line
+
+    // vertex
+    if (token[0] == 'v' && isSpace((token[1]))) {
+      token += 2;
+      float x, y, z;
+      parseFloat3(x, y, z, token);
+      chunk.v.push_back(x);
+      chunk.v.push_back(y);
+      chunk.v.push_back(z);
       continue;
     }
 
-    // load mtl
-    if ((0 == strncmp(token, "mtllib", 6)) && isSpace((token[6]))) {
-      char namebuf[TINYOBJ_SSCANF_BUFFER_SIZE];
-      token += 7;
-#ifdef _MSC_VER
-      sscanf_s(token, "%s", namebuf, (unsigned)_countof(namebuf));
-#else
-      sscanf(token, "%s", namebuf);
-#endif
+    // normal
+    if (token[0] == 'v' && token[1] == 'n' && isSpace((token[2]))) {
+      token += 3;
+      float x, y, z;
+      parseFloat3(x, y, z, token);
+      chunk.vn.push_back(x);
+      chunk.vn.push_back(y);
+      chunk.vn.push_back(z);
+      continue;
+    }
 
-      std::string err_mtl;
-      bool ok = readMatFn(namebuf, materials, material_map, err_mtl);
-      err += err_mtl;
-      
-      if (!ok) {
-        faceGroup.clear(); // for safety
-        return false;
-      }
+    // texcoord
+    if (token[0] == 'v' && token[1] == 't' && isSpace((token[2]))) {
+      token += 3;
+      float x, y;
+      parseFloat2(x, y, token);
+      chunk.vt.push_back(x);
+      chunk.vt.push_back(y);
+      continue;
+    }
 
+    // face
+    if (token[0] == 'f' && isSpace((token[1]))) {
+      obj_face_line face = {line, static_cast<int>(chunk.v.size() / 3),
+                            static_cast<int>(chunk.vn.size() / 3),
+                            static_cast<int>(chunk.vt.size() / 2)};
+      chunk.faceLines.push_back(face);
       continue;
     }
 
-    // group name
-    if (token[0] == 'g' && isSpace((token[1]))) {
+    // group commands are replayed in order on one thread
+    if (((0 == strncmp(token, "usemtl", 6) ||
+          0 == strncmp(token, "mtllib", 6)) && isSpace((token[6]))) ||
+        ((token[0] == 'g' || token[0] == 'o') && isSpace((token[1])))) {
+      obj_command_line command;
+      copyLine(line, chunk.end, command.line);
+      command.faces = chunk.faceLines.size();
+      chunk.commands.push_back(command);
+    }
+  }
+}
+
+// Second pass over a chunk: parse its faces against the global counts and
+// copy its vertex data to the prefix-summed offsets in v, vn and vt.
+static void resolveChunk(obj_chunk &chunk, std::vector<float> &v,
+                         std::vector<float> &vn, std::vector<float> &vt) {
+  std::copy(chunk.v.begin(), chunk.v.end(), v.begin() + 3 * chunk.vOffset);
+  std::copy(chunk.vn.begin(), chunk.vn.end(), vn.begin() + 3 * chunk.vnOffset);
+  std::copy(chunk.vt.begin(), chunk.vt.end(), vt.begin() + 2 * chunk.vtOffset);
+  std::vector<float>().swap(chunk.v);
+  std::vector<float>().swap(chunk.vn);
+  std::vector<float>().swap(chunk.vt);
+
+  std::string linebuf;
+  chunk.faceSizes.reserve(chunk.faceLines.size());
+  for (size_t i = 0; i < chunk.faceLines.size(); i++) {
+    const obj_face_line &face = chunk.faceLines[i];
+    const char *token;
+    nextLine(face.line, chunk.end, linebuf, token);
+    token += strspn(token, " \t");
 
-      // flush previous face group.
-      bool ret = exportFaceGroupToShape(shape, vertexCache, v, vn, vt,
-                                        faceGroup, material, name, true);
-      if (ret) {
-        shapes.push_back(shape);
+    size_t before = chunk.faceVerts.size();
+    parseFace(token + 2, static_cast<int>(chunk.vOffset) + face.v,
+              static_cast<int>(chunk.vnOffset) + face.vn,
+              static_cast<int>(chunk.vtOffset) + face.vt, chunk.faceVerts);
+    chunk.faceSizes.push_back(chunk.faceVerts.size() - before);
+  }
+  std::vector<obj_face_line>().swap(chunk.faceLines);
+}
+
+// Run body(0) .. body(count - 1) on up to numThreads threads.
+template <typename Body>
+static void parallelForChunks(size_t count, unsigned int numThreads,
+                              Body body) {
+  std::atomic<size_t> next(0);
+  std::vector<std::thread> workers;
+  for (unsigned int t = 1; t < numThreads && t < count; t++) {
+    workers.push_back(std::thread([&]() {
+      for (size_t i; (i = next++) < count;) {
+        body(i);
       }
+    }));
+  }
+  for (size_t i; (i = next++) < count;) {
+    body(i);
+  }
+  for (size_t t = 0; t < workers.size(); t++) {
+    workers[t].join();
+  }
+}
 
-      shape = shape_t();
+// The chunked loader. When the bytes are a mapped `file` the pages of each
+// chunk are released as soon as its faces are parsed.
+static bool loadObjChunks(std::vector<shape_t> &shapes,
+                          std::vector<material_t> &materials,
+                          std::string &err, const char *buf, size_t size,
+                          MaterialReader &readMatFn, unsigned int num_threads,
+                          const MappedFile *file) {
+  std::stringstream errss;
 
-      // material = -1;
-      faceGroup.clear();
+  if (num_threads == 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
 
-      std::vector<std::string> names;
-      while (!isNewLine(token[0])) {
-        std::string str = parseString(token);
-        names.push_back(str);
-        token += strspn(token, " \t\r"); // skip tag
-      }
+  // A few chunks per thread for balance, but none smaller than 64 KB.
+  const size_t minChunk = 1 << 16;
+  size_t numChunks = num_threads == 1 ? 1 : std::max<size_t>(
+      1, std::min<size_t>(4 * num_threads, size / minChunk));
+  std::vector<obj_chunk> chunks(numChunks);
+  const char *end = buf + size;
+  const char *p = buf;
+  for (size_t i = 0; i < numChunks; i++) {
+    chunks[i].begin = p;
+    if (i + 1 == numChunks) {
+      p = end;
+    } else {
+      // move the split to just past the next line break
+      p = std::max(p, buf + size * (i + 1) / numChunks);
+      const char *eol = static_cast<const char *>(
+          memchr(p, '\n', static_cast<size_t>(end - p)));
+      p = eol ? eol + 1 : end;
+    }
+    chunks[i].end = p;
+  }
 
-      assert(names.size() > 0);
+  parallelForChunks(numChunks, num_threads,
+                    [&](size_t i) { scanChunk(chunks[i]); });
+
+  // prefix sum the vertex counts into each chunk's index offsets
+  size_t vCount = 0, vnCount = 0, vtCount = 0;
+  for (size_t i = 0; i < numChunks; i++) {
+    chunks[i].vOffset = vCount;
+    chunks[i].vnOffset = vnCount;
+    chunks[i].vtOffset = vtCount;
+    vCount += chunks[i].v.size() / 3;
+    vnCount += chunks[i].vn.size() / 3;
+    vtCount += chunks[i].vt.size() / 2;
+  }
 
-      // names[0] must be 'g', so skip the 0th element.
-      if (names.size() > 1) {
-        name = names[1];
-      } else {
-        name = "";
+  std::vector<float> v(3 * vCount);
+  std::vector<float> vn(3 * vnCount);
+  std::vector<float> vt(2 * vtCount);
+  parallelForChunks(numChunks, num_threads, [&](size_t i) {
+    resolveChunk(chunks[i], v, vn, vt);
+    if (file) {
+      file->release(chunks[i].begin, chunks[i].end);
+    }
+  });
+
+  // Build the shapes in file order. The face groups and group commands are
+  // ordered, so this part stays on one thread.
+  obj_group_state state;
+  for (size_t i = 0; i < numChunks; i++) {
+    obj_chunk &chunk = chunks[i];
+    size_t face = 0, vert = 0;
+    for (size_t c = 0; c <= chunk.commands.size(); c++) {
+      size_t faces =
+          c < chunk.commands.size() ? chunk.commands[c].faces : chunk.faceSizes.size();
+      for (; face < faces; face++) {
+        const vertex_index *first = chunk.faceVerts.data() + vert;
+        state.faceGroup.push_back(
+            std::vector<vertex_index>(first, first + chunk.faceSizes[face]));
+        vert += chunk.faceSizes[face];
+      }
+      if (c == chunk.commands.size()) {
+        break;
       }
 
-      continue;
+      const char *token = chunk.commands[c].line.c_str();
+      token += strspn(token, " \t");
+      bool ok;
+      parseGroupCommand(token, state, shapes, materials, err, readMatFn, v, vn,
+                        vt, ok);
+      if (!ok) {
+        return false;
+      }
     }
+    std::vector<vertex_index>().swap(chunk.faceVerts);
+  }
 
-    // object name
-    if (token[0] == 'o' && isSpace((token[1]))) {
+  flushFaceGroup(state, shapes, v, vn, vt); // for safety
 
-      // flush previous face group.
-      bool ret = exportFaceGroupToShape(shape, vertexCache, v, vn, vt,
-                                        faceGroup, material, name, true);
-      if (ret) {
-        shapes.push_back(shape);
-      }
+  err += errss.str();
+  return true;
+}
 
-      // material = -1;
-      faceGroup.clear();
-      shape = shape_t();
+bool LoadObjParallel(std::vector<shape_t> &shapes, // [output]
+                     std::vector<material_t> &materials, // [output]
+                     std::string &err, const char *buf, size_t size,
+                     MaterialReader &readMatFn, unsigned int num_threads) {
+  return loadObjChunks(shapes, materials, err, buf, size, readMatFn,
+                       num_threads, NULL);
+}
 
-      // @todo { multiple object name? }
-      char namebuf[TINYOBJ_SSCANF_BUFFER_SIZE];
-      token += 2;
-#ifdef _MSC_VER
-      sscanf_s(token, "%s", namebuf, (unsigned)_countof(namebuf));
-#else
-      sscanf(token, "%s", namebuf);
-#endif
-      name = std::string(namebuf);
+bool LoadObjParallel(std::vector<shape_t> &shapes, // [output]
+                     std::vector<material_t> &materials, // [output]
+                     std::string &err, const char *filename,
+                     const char *mtl_basepath, unsigned int num_threads) {
 
-      continue;
-    }
+  shapes.clear();
 
-    // Ignore unknown command.
+  std::stringstream errss;
+
+  // the chunks are parsed straight out of the mapped file
+  MappedFile file;
+  if (!file.open(filename)) {
+    errss << "Cannot open file [" << filename << "]" << std::endl;
+    err = errss.str();
+    return false;
   }
 
-  bool ret = exportFaceGroupToShape(shape, vertexCache, v, vn, vt, faceGroup,
-                                    material, name, true);
-  if (ret) {
-    shapes.push_back(shape);
+  std::string basePath;
+  if (mtl_basepath) {
+    basePath = mtl_basepath;
   }
-  faceGroup.clear(); // for safety
+  MaterialFileReader matFileReader(basePath);
 
-  err += errss.str();
-  return true;
+  return loadObjChunks(shapes, materials, err, file.data(), file.size(),
+                       matFileReader, num_threads, &file);
 }
 
 } // namespace
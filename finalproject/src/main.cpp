@@ -12,6 +12,7 @@
 #include "GLSL.h"
 #include "Program.h"
 #include "Shape.h"
+#include "MeshCache.h"
 #include "MatrixStack.h"
 #include "WindowManager.h"
 #include "Texture.h"
@@ -400,10 +401,10 @@ public:
         //  Initialize mesh
         //  Load geometry
         //  Some obj files contain material information.We'll ignore them for this assignment.
-        vector<tinyobj::shape_t> TOshapes;
+        MeshCache cache;
         string errStr;
         // load in the mesh and make the shape(s)
-        bool rc = tinyobj::LoadObj(TOshapes, sphereMaterials, errStr, (resourceDirectory + "/sphereWTex.obj").c_str());
+        bool rc = cache.load(resourceDirectory + "/sphereWTex.obj", sphereMaterials, errStr);
         if (!rc)
         {
             cerr << errStr << endl;
@@ -411,8 +412,7 @@ public:
         else
         {
             sphere = make_shared<Shape>();
-            sphere->createShape(TOshapes[0]);
-            sphere->measure();
+            sphere->createShape(cache.getShapes()[0]);
             sphere->init();
         }
 
@@ -453,21 +453,21 @@ public:
     vector<shared_ptr<Shape>> loadModel(const std::string &filename, const std::string &resourceDirectory, std::vector<tinyobj::material_t> &materialsOut)
     {
         vector<shared_ptr<Shape>> model;
-        vector<tinyobj::shape_t> TOshapes;
+        MeshCache cache;
         string errStr;
 
-        bool rc = tinyobj::LoadObj(TOshapes, materialsOut, errStr, (resourceDirectory + filename).c_str());
+        // maps the binary cache next to the .obj, or parses the .obj on every core and writes the cache
+        bool rc = cache.load(resourceDirectory + filename, materialsOut, errStr);
         if (!rc)
         {
             cerr << "Failed to load " << filename << ": " << errStr << endl;
             return model;
         }
 
-        for (auto &TOshape : TOshapes)
+        for (const CachedMesh &mesh : cache.getShapes())
         {
             auto shape = make_shared<Shape>();
-            shape->createShape(TOshape);
-            shape->measure();
+            shape->createShape(mesh);
             shape->init();
             model.push_back(shape);
         }
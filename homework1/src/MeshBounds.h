@@ -0,0 +1,50 @@
+#ifndef MESH_BOUNDS_H
+#define MESH_BOUNDS_H
+
+#include <cstddef>
+#include <vector>
+#include "tiny_obj_loader.h"
+
+/*
+    The uniform scale and shift that fit a mesh into [-1, 1] on its longest
+    axis and center it: p' = (p - shift) * scale
+*/
+typedef struct
+{
+    float shift[3];
+    float scale;
+} MeshNormalization;
+
+/* Start empty bounds, ready for growBounds */
+inline void initBounds(float lo[3], float hi[3])
+{
+    for (int c = 0; c < 3; c++)
+    {
+        lo[c] = 1.1754E+38F;
+        hi[c] = -1.1754E+38F;
+    }
+}
+
+/*
+    Grow lo and hi to take in count interleaved xyz positions, reduced in
+    chunks on numThreads threads, 8 vertices at a time with AVX when the CPU
+    supports it. Positions can be fed a piece at a time, for example while a
+    file is streamed in.
+*/
+void growBounds(const float *positions, size_t count, float lo[3], float hi[3], int numThreads, bool forceScalar);
+
+/* The normalization that fits the bounds into [-1, 1] */
+MeshNormalization normalizationFromBounds(const float lo[3], const float hi[3]);
+
+/*
+    Find the bounds of every position of every shape with growBounds and the
+    normalization they give
+*/
+MeshNormalization computeNormalization(const std::vector<tinyobj::shape_t> &shapes, int numThreads,
+                                       bool forceScalar);
+
+/* Rewrite every position in place, chunked and vectorized the same way */
+void applyNormalization(std::vector<tinyobj::shape_t> &shapes, const MeshNormalization &norm, int numThreads,
+                        bool forceScalar);
+
+#endif
@@ -0,0 +1,35 @@
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "Parallel.h"
+
+using namespace std;
+
+void parallelFor(int count, int numThreads, const function<void(int)> &body)
+{
+	numThreads = max(1, min(numThreads, count));
+	if(numThreads == 1) {
+		for(int i = 0; i < count; i++) {
+			body(i);
+		}
+		return;
+	}
+
+	atomic<int> next(0);
+	auto worker = [&]() {
+		for(int i = next++; i < count; i = next++) {
+			body(i);
+		}
+	};
+
+	// The calling thread works too instead of idling in join()
+	vector<thread> threads;
+	for(int t = 1; t < numThreads; t++) {
+		threads.emplace_back(worker);
+	}
+	worker();
+	for(auto &t : threads) {
+		t.join();
+	}
+}
@@ -0,0 +1,12 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <functional>
+
+/*
+    Run body(i) for every i in [0, count) on numThreads worker threads.
+    Work items are handed out one at a time so uneven items balance out.
+*/
+void parallelFor(int count, int numThreads, const std::function<void(int)> &body);
+
+#endif
@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <cstring>
+#include "Parallel.h"
+#include "PointSplat.h"
+
+using namespace std;
+
+// points per work item handed to a thread
+static const size_t BLOCK_POINTS = 1 << 16;
+static const uint64_t EMPTY_PIXEL = ~uint64_t(0);
+
+// float bits as an unsigned integer in the same order as the floats
+static uint32_t orderedBits(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+}
+
+// blue, cyan, green, yellow, red for t from 0 to 1
+static uint32_t rampColor(float t)
+{
+	static const float stops[5][3] = {{0, 0, 1}, {0, 1, 1}, {0, 1, 0}, {1, 1, 0}, {1, 0, 0}};
+	t = min(max(t, 0.0f), 1.0f) * 4.0f;
+	int i = min(static_cast<int>(t), 3);
+	float f = t - i;
+	uint32_t rgb = 0;
+	for(int c = 0; c < 3; c++) {
+		float v = stops[i][c] + (stops[i + 1][c] - stops[i][c]) * f;
+		rgb = (rgb << 8) | static_cast<uint32_t>(v * 255.0f + 0.5f);
+	}
+	return rgb;
+}
+
+static void atomicMin(atomic<uint64_t> &pixel, uint64_t value)
+{
+	uint64_t current = pixel.load(memory_order_relaxed);
+	while(value < current && !pixel.compare_exchange_weak(current, value, memory_order_relaxed)) {
+	}
+}
+
+PointSplatter::PointSplatter(int width, int height) :
+	m_width(width),
+	m_height(height),
+	m_pixels(size_t(width) * height)
+{
+	for(auto &pixel : m_pixels) {
+		pixel.store(EMPTY_PIXEL, memory_order_relaxed);
+	}
+}
+
+void PointSplatter::splat(const float *points, size_t count, const SplatParams &params, int numThreads)
+{
+	// the resize and the viewport as one scale and offset per axis
+	const MeshNormalization &norm = params.norm;
+	float pixelScale = params.scale * norm.scale;
+	double offsetX = params.centerX - norm.shift[0] * pixelScale;
+	double offsetY = params.centerY - norm.shift[1] * pixelScale;
+	int before = (params.splatSize - 1) / 2, after = params.splatSize / 2;
+
+	int blocks = static_cast<int>((count + BLOCK_POINTS - 1) / BLOCK_POINTS);
+	parallelFor(blocks, numThreads, [&](int block) {
+		size_t end = min((block + 1) * BLOCK_POINTS, count);
+		for(size_t i = block * BLOCK_POINTS; i < end; i++) {
+			const float *p = points + 3 * i;
+			int x = static_cast<int>(offsetX + p[0] * pixelScale);
+			int y = static_cast<int>(offsetY + p[1] * pixelScale);
+			int x0 = max(x - before, 0), x1 = min(x + after, m_width - 1);
+			int y0 = max(y - before, 0), y1 = min(y + after, m_height - 1);
+			if(x0 > x1 || y0 > y1) {
+				continue;
+			}
+
+			// the viewer looks down -z, so a larger z is closer and gets a smaller key
+			float z = (p[2] - norm.shift[2]) * norm.scale;
+			uint32_t rgb = 0xffffff;
+			if(params.color == COLOR_DEPTH) {
+				rgb = rampColor((z + 1.0f) * 0.5f);
+			} else if(params.color == COLOR_HEIGHT) {
+				rgb = rampColor(((p[1] - norm.shift[1]) * norm.scale + 1.0f) * 0.5f);
+			}
+			uint64_t value = (uint64_t(orderedBits(-z)) << 32) | rgb;
+			for(int py = y0; py <= y1; py++) {
+				for(int px = x0; px <= x1; px++) {
+					atomicMin(m_pixels[size_t(py) * m_width + px], value);
+				}
+			}
+		}
+	});
+}
+
+size_t PointSplatter::resolve(Image &image) const
+{
+	size_t covered = 0;
+	for(int y = 0; y < m_height; y++) {
+		for(int x = 0; x < m_width; x++) {
+			uint64_t value = m_pixels[size_t(y) * m_width + x].load(memory_order_relaxed);
+			if(value == EMPTY_PIXEL) {
+				continue;
+			}
+			image.setPixel(x, y, (value >> 16) & 0xff, (value >> 8) & 0xff, value & 0xff);
+			covered++;
+		}
+	}
+	return covered;
+}
@@ -0,0 +1,55 @@
+#ifndef POINT_SPLAT_H
+#define POINT_SPLAT_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "Image.h"
+#include "MeshBounds.h"
+
+/* What a point is colored by */
+enum PointColor
+{
+    COLOR_WHITE,
+    COLOR_DEPTH,  // closer points are warmer
+    COLOR_HEIGHT  // higher points (larger y) are warmer
+};
+
+/* How raw positions are mapped to pixels and colored */
+typedef struct
+{
+    // applied to the raw positions first, identity when they are already resized
+    MeshNormalization norm;
+    // pixels per unit of the resized mesh and the pixel of its origin
+    float scale;
+    double centerX, centerY;
+    // width and height of the square drawn for every point
+    int splatSize;
+    PointColor color;
+} SplatParams;
+
+/*
+    Orthographic point renderer that keeps the closest point of every pixel.
+    Each pixel is one 64-bit word holding the depth of its closest point in
+    the high half, as an unsigned integer that grows away from the viewer,
+    and the color of that point in the low half. Points are splatted on many
+    threads at once with an atomic min on the word, so depth test and color
+    write are a single operation and no locks are needed. Ties are broken by
+    the color, so the picture does not depend on the thread schedule.
+*/
+class PointSplatter
+{
+public:
+    PointSplatter(int width, int height);
+
+    // project and depth test count interleaved xyz points, in blocks spread over numThreads threads
+    void splat(const float *points, size_t count, const SplatParams &params, int numThreads);
+    // write the color of every pixel a point reached, returns how many there are
+    size_t resolve(Image &image) const;
+
+private:
+    int m_width, m_height;
+    std::vector<std::atomic<uint64_t>> m_pixels;
+};
+
+#endif
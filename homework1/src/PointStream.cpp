@@ -0,0 +1,101 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include "PointStream.h"
+
+using namespace std;
+
+// bytes read from the file at a time
+static const size_t BUFFER_SIZE = 1 << 22;
+
+static bool endsWith(const string &s, const string &suffix)
+{
+	return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+PointStream::PointStream(const string &filename) :
+	m_file(filename.c_str(), ios::binary),
+	m_obj(endsWith(filename, ".obj") || endsWith(filename, ".OBJ")),
+	m_buffer(BUFFER_SIZE + 1),
+	m_pos(0),
+	m_end(0),
+	m_eof(false)
+{
+}
+
+void PointStream::rewind()
+{
+	m_file.clear();
+	m_file.seekg(0);
+	m_pos = m_end = 0;
+	m_eof = false;
+}
+
+bool PointStream::refill()
+{
+	if(m_eof) {
+		return false;
+	}
+	memmove(&m_buffer[0], &m_buffer[m_pos], m_end - m_pos);
+	m_end -= m_pos;
+	m_pos = 0;
+	// a line longer than the buffer makes it grow, one byte stays free for a terminator
+	if(m_end + 1 >= m_buffer.size()) {
+		m_buffer.resize(2 * m_buffer.size());
+	}
+	m_file.read(&m_buffer[m_end], m_buffer.size() - 1 - m_end);
+	m_end += static_cast<size_t>(m_file.gcount());
+	m_eof = !m_file;
+	return true;
+}
+
+bool PointStream::parseLine(char *line, float xyz[3]) const
+{
+	while(*line == ' ' || *line == '\t') {
+		line++;
+	}
+	if(m_obj) {
+		if(line[0] != 'v' || (line[1] != ' ' && line[1] != '\t')) {
+			return false;
+		}
+		line += 2;
+	}
+	for(int c = 0; c < 3; c++) {
+		char *next;
+		xyz[c] = strtof(line, &next);
+		if(next == line) {
+			return false;
+		}
+		line = next;
+	}
+	return true;
+}
+
+size_t PointStream::read(vector<float> &points, size_t maxPoints)
+{
+	points.clear();
+	size_t count = 0;
+	while(count < maxPoints) {
+		char *start = &m_buffer[m_pos];
+		char *newline = static_cast<char *>(memchr(start, '\n', m_end - m_pos));
+		if(!newline) {
+			if(refill()) {
+				continue;
+			}
+			// the last line may have no newline
+			if(m_pos == m_end) {
+				break;
+			}
+			newline = &m_buffer[m_end];
+		}
+		// end the line so the number parser cannot run into the next one
+		*newline = '\0';
+		m_pos = min(static_cast<size_t>(newline - &m_buffer[0]) + 1, m_end);
+		float xyz[3];
+		if(parseLine(start, xyz)) {
+			points.insert(points.end(), xyz, xyz + 3);
+			count++;
+		}
+	}
+	return count;
+}
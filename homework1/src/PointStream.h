@@ -0,0 +1,38 @@
+#ifndef POINT_STREAM_H
+#define POINT_STREAM_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+/*
+    Reads the points of a text file a chunk at a time, so a point set much
+    larger than memory can be rendered. In an OBJ file every "v x y z" line is
+    a point and every other line is skipped; any other file is read as one
+    point per line, the first three numbers on the line. Only one buffer of
+    the file and the points of the current chunk are held in memory.
+*/
+class PointStream
+{
+public:
+    explicit PointStream(const std::string &filename);
+
+    bool isOpen() const { return m_file.is_open(); }
+    // read up to maxPoints points into points as interleaved xyz, returns how many, 0 at the end
+    size_t read(std::vector<float> &points, size_t maxPoints);
+    // start over from the first point
+    void rewind();
+
+private:
+    // move the unread bytes to the front and read more after them, false at the end of the file
+    bool refill();
+    bool parseLine(char *line, float xyz[3]) const;
+
+    std::ifstream m_file;
+    bool m_obj;
+    std::vector<char> m_buffer;
+    size_t m_pos, m_end;
+    bool m_eof;
+};
+
+#endif
@@ -4,10 +4,15 @@
 #include <string>
 #include <vector>
 #include <memory>
-#include <assert.h>
+#include <thread>
+#include <algorithm>
+#include <chrono>
 
 #include "tiny_obj_loader.h"
 #include "Image.h"
+#include "MeshBounds.h"
+#include "PointSplat.h"
+#include "PointStream.h"
 
 // This allows you to skip the `std::` in front of C++ standard library
 // functions. You can also say `using std::cout` to be more selective.
@@ -21,79 +26,45 @@ int g_width, g_height;
    Given a vector of shapes which has already been read from an obj file
    resize all vertices to the range [-1, 1]
  */
-void resize_obj(std::vector<tinyobj::shape_t> &shapes)
+void resize_obj(std::vector<tinyobj::shape_t> &shapes, int numThreads)
 {
-    float minX, minY, minZ;
-    float maxX, maxY, maxZ;
-    float scaleX, scaleY, scaleZ;
-    float shiftX, shiftY, shiftZ;
-    float epsilon = 0.001;
-
-    minX = minY = minZ = 1.1754E+38F;
-    maxX = maxY = maxZ = -1.1754E+38F;
+    // the bounds and the rescale are both chunked over the threads and vectorized
+    applyNormalization(shapes, computeNormalization(shapes, numThreads, false), numThreads, false);
+}
 
-    // Go through all vertices to determine min and max of each dimension
-    for (size_t i = 0; i < shapes.size(); i++)
+/*
+    Stream the points of a file twice, a chunk at a time: once to find their
+    bounds and once to splat them, so the point set never has to fit in
+    memory. The resize is always folded into the projection.
+*/
+bool splatStream(const string &fileName, PointSplatter &splatter, SplatParams &params, size_t chunkPoints,
+                 int numThreads)
+{
+    PointStream stream(fileName);
+    if (!stream.isOpen())
     {
-        for (size_t v = 0; v < shapes[i].mesh.positions.size() / 3; v++)
-        {
-            if (shapes[i].mesh.positions[3 * v + 0] < minX)
-                minX = shapes[i].mesh.positions[3 * v + 0];
-            if (shapes[i].mesh.positions[3 * v + 0] > maxX)
-                maxX = shapes[i].mesh.positions[3 * v + 0];
-
-            if (shapes[i].mesh.positions[3 * v + 1] < minY)
-                minY = shapes[i].mesh.positions[3 * v + 1];
-            if (shapes[i].mesh.positions[3 * v + 1] > maxY)
-                maxY = shapes[i].mesh.positions[3 * v + 1];
-
-            if (shapes[i].mesh.positions[3 * v + 2] < minZ)
-                minZ = shapes[i].mesh.positions[3 * v + 2];
-            if (shapes[i].mesh.positions[3 * v + 2] > maxZ)
-                maxZ = shapes[i].mesh.positions[3 * v + 2];
-        }
+        cerr << "Couldn't open " << fileName << endl;
+        return false;
     }
 
-    // From min and max compute necessary scale and shift for each dimension
-    float maxExtent, xExtent, yExtent, zExtent;
-    xExtent = maxX - minX;
-    yExtent = maxY - minY;
-    zExtent = maxZ - minZ;
-    if (xExtent >= yExtent && xExtent >= zExtent)
-    {
-        maxExtent = xExtent;
-    }
-    if (yExtent >= xExtent && yExtent >= zExtent)
-    {
-        maxExtent = yExtent;
-    }
-    if (zExtent >= xExtent && zExtent >= yExtent)
+    vector<float> points;
+    float lo[3], hi[3];
+    initBounds(lo, hi);
+    size_t total = 0, chunks = 0;
+    for (size_t count; (count = stream.read(points, chunkPoints)) > 0; chunks++)
     {
-        maxExtent = zExtent;
-    }
-    scaleX = 2.0 / maxExtent;
-    shiftX = minX + (xExtent / 2.0);
-    scaleY = 2.0 / maxExtent;
-    shiftY = minY + (yExtent / 2.0);
-    scaleZ = 2.0 / maxExtent;
-    shiftZ = minZ + (zExtent) / 2.0;
-
-    // Go through all verticies shift and scale them
-    for (size_t i = 0; i < shapes.size(); i++)
-    {
-        for (size_t v = 0; v < shapes[i].mesh.positions.size() / 3; v++)
-        {
-            shapes[i].mesh.positions[3 * v + 0] = (shapes[i].mesh.positions[3 * v + 0] - shiftX) * scaleX;
-            assert(shapes[i].mesh.positions[3 * v + 0] >= -1.0 - epsilon);
-            assert(shapes[i].mesh.positions[3 * v + 0] <= 1.0 + epsilon);
-            shapes[i].mesh.positions[3 * v + 1] = (shapes[i].mesh.positions[3 * v + 1] - shiftY) * scaleY;
-            assert(shapes[i].mesh.positions[3 * v + 1] >= -1.0 - epsilon);
-            assert(shapes[i].mesh.positions[3 * v + 1] <= 1.0 + epsilon);
-            shapes[i].mesh.positions[3 * v + 2] = (shapes[i].mesh.positions[3 * v + 2] - shiftZ) * scaleZ;
-            assert(shapes[i].mesh.positions[3 * v + 2] >= -1.0 - epsilon);
-            assert(shapes[i].mesh.positions[3 * v + 2] <= 1.0 + epsilon);
-        }
+        growBounds(&points[0], count, lo, hi, numThreads, false);
+        total += count;
     }
+    cout << "Number of points: " << total << " in " << chunks << " chunks" << endl;
+    if (total == 0)
+        return true;
+    params.norm = normalizationFromBounds(lo, hi);
+
+    stream.rewind();
+    for (size_t count; (count = stream.read(points, chunkPoints)) > 0;)
+        splatter.splat(&points[0], count, params, numThreads);
+    return true;
 }
 
 int main(int argc, char **argv)
@@ -103,9 +74,10 @@ int main(int argc, char **argv)
     //       return 0;
     //    }
 
-    if (argc != 6)
+    if (argc < 6)
     {
-        cout << "Usage: " << argv[0] << " <meshfile> <imagefile> <width> <height> <mode>" << endl;
+        cout << "Usage: " << argv[0] << " <meshfile> <imagefile> <width> <height> <mode> [--threads N] [--fold-resize]"
+             << " [--splat N] [--color <white|depth|height>] [--stream] [--chunk N]" << endl;
         return 0;
     }
 
@@ -118,43 +90,116 @@ int main(int argc, char **argv)
     g_width = stoi(argv[3]);
     g_height = stoi(argv[4]);
 
+    // optional flags
+    int numThreads = max(1, static_cast<int>(thread::hardware_concurrency()));
+    // leave the positions alone and apply the resize when they are projected
+    bool foldResize = false;
+    // read the points from disk a chunk of chunkPoints at a time
+    bool stream = false;
+    size_t chunkPoints = 1 << 20;
+    SplatParams params;
+    params.splatSize = 1;
+    params.color = COLOR_WHITE;
+    for (int i = 6; i < argc; i++)
+    {
+        string arg(argv[i]);
+        if (arg == "--threads" && i + 1 < argc)
+        {
+            numThreads = max(1, stoi(argv[++i]));
+        }
+        else if (arg == "--fold-resize")
+        {
+            foldResize = true;
+        }
+        else if (arg == "--splat" && i + 1 < argc)
+        {
+            params.splatSize = max(1, stoi(argv[++i]));
+        }
+        else if (arg == "--color" && i + 1 < argc)
+        {
+            string color(argv[++i]);
+            if (color == "white")
+                params.color = COLOR_WHITE;
+            else if (color == "depth")
+                params.color = COLOR_DEPTH;
+            else if (color == "height")
+                params.color = COLOR_HEIGHT;
+            else
+            {
+                cout << "Unknown color: " << color << endl;
+                return 0;
+            }
+        }
+        else if (arg == "--stream")
+        {
+            stream = true;
+        }
+        else if (arg == "--chunk" && i + 1 < argc)
+        {
+            chunkPoints = max(1, stoi(argv[++i]));
+        }
+        else
+        {
+            cout << "Unknown option: " << arg << endl;
+            return 0;
+        }
+    }
+
     // create an image
     auto image = make_shared<Image>(g_width, g_height);
 
-    // triangle buffer
-    vector<unsigned int> triBuf;
-    // position buffer
-    vector<float> posBuf;
-    // Some obj files contain material information.
-    // We'll ignore them for this assignment.
-    vector<tinyobj::shape_t> shapes;          // geometry
-    vector<tinyobj::material_t> objMaterials; // material
-    string errStr;
-
-    bool rc = tinyobj::LoadObj(shapes, objMaterials, errStr, meshName.c_str());
-    /* error checking on read */
-    if (!rc)
+    // the resized mesh fills the shorter side of the image
+    params.norm = MeshNormalization{{0.0f, 0.0f, 0.0f}, 1.0f};
+    params.scale = (min(g_width, g_height) - 1) * 0.5f;
+    params.centerX = (g_width - 1) * 0.5;
+    params.centerY = (g_height - 1) * 0.5;
+    PointSplatter splatter(g_width, g_height);
+
+    auto start = chrono::steady_clock::now();
+    if (stream)
     {
-        cerr << errStr << endl;
+        if (!splatStream(meshName, splatter, params, chunkPoints, numThreads))
+            return 0;
     }
     else
     {
-        // keep this code to resize your object to be within -1 -> 1
-        resize_obj(shapes);
-        posBuf = shapes[0].mesh.positions;
-        triBuf = shapes[0].mesh.indices;
-    }
-    cout << "Number of vertices: " << posBuf.size() / 3 << endl;
-    cout << "Number of triangles: " << triBuf.size() / 3 << endl;
+        // Some obj files contain material information.
+        // We'll ignore them for this assignment.
+        vector<tinyobj::shape_t> shapes;          // geometry
+        vector<tinyobj::material_t> objMaterials; // material
+        string errStr;
+
+        bool rc = tinyobj::LoadObj(shapes, objMaterials, errStr, meshName.c_str());
+        /* error checking on read */
+        if (!rc)
+        {
+            cerr << errStr << endl;
+        }
+        else
+        {
+            // keep this code to resize your object to be within -1 -> 1
+            if (foldResize)
+                params.norm = computeNormalization(shapes, numThreads, false);
+            else
+                resize_obj(shapes, numThreads);
+        }
 
-    // TODO add code to iterate through each triangle and rasterize it
-    float scale = (min(g_width, g_height) - 1) * 0.5f;
-    for (size_t v = 0; v < posBuf.size() / 3; v++)
-    {
-        int x = static_cast<int>((g_width - 1) * 0.5 + posBuf[3 * v + 0] * scale);
-        int y = static_cast<int>((g_height - 1) * 0.5 + posBuf[3 * v + 1] * scale);
-        image->setPixel(x, y, 255, 255, 255);
+        // every vertex of every shape is a point
+        size_t numVertices = 0, numTriangles = 0;
+        for (const tinyobj::shape_t &shape : shapes)
+        {
+            size_t count = shape.mesh.positions.size() / 3;
+            if (count > 0)
+                splatter.splat(&shape.mesh.positions[0], count, params, numThreads);
+            numVertices += count;
+            numTriangles += shape.mesh.indices.size() / 3;
+        }
+        cout << "Number of vertices: " << numVertices << endl;
+        cout << "Number of triangles: " << numTriangles << endl;
     }
+    size_t covered = splatter.resolve(*image);
+    cout << "Splatting: " << chrono::duration<double>(chrono::steady_clock::now() - start).count() * 1000.0
+         << " ms, " << covered << " pixels covered" << endl;
 
     // write out the image
     image->writeToFile(imgName);
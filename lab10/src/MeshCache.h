@@ -0,0 +1,76 @@
+#pragma once
+
+#ifndef LAB471_MESHCACHE_H_INCLUDED
+#define LAB471_MESHCACHE_H_INCLUDED
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "tiny_obj_loader.h"
+
+// One shape of a loaded mesh. The arrays point into the mapped cache file,
+// or into the freshly parsed shapes, and stay valid while the MeshCache that
+// loaded them does.
+struct CachedMesh
+{
+    std::string name;
+    const float *positions;
+    size_t numPositions;
+    const float *normals;
+    size_t numNormals;
+    const float *texcoords;
+    size_t numTexcoords;
+    const unsigned int *indices;
+    size_t numIndices;
+    const int *materialIds;
+    size_t numMaterialIds;
+    // bounds of the positions, as Shape::measure finds them
+    float min[3];
+    float max[3];
+};
+
+// Loads an .obj through a binary cache written next to it as <file>.cache.
+// The cache holds the deduplicated positions, normals, texcoords, indices,
+// material ids and bounds of every shape, and the names of the material
+// libraries. It is used while the .obj keeps the size, modification time
+// and content hash it was written for; later loads map it and hand its
+// arrays to Shape without parsing anything. Otherwise the .obj is parsed
+// and the cache is written again. Materials are always read from the .mtl
+// files, so they are never stale.
+class MeshCache
+{
+public:
+    MeshCache();
+    ~MeshCache();
+
+    bool load(const std::string &objFile, std::vector<tinyobj::material_t> &materials, std::string &err);
+
+    const std::vector<CachedMesh> &getShapes() const { return shapes; }
+    bool isFromCache() const { return fromCache; }
+
+private:
+    class Bytes;
+
+    // what a cache is checked against: the size, modification time and
+    // content hash of its .obj
+    struct Stamp
+    {
+        unsigned long long size;
+        long long time;
+        unsigned long long hash;
+    };
+
+    MeshCache(const MeshCache &) = delete;
+    MeshCache &operator=(const MeshCache &) = delete;
+
+    bool readCache(const std::string &cacheFile, const Stamp &stamp, std::vector<tinyobj::material_t> &materials,
+                   std::string &err);
+    void writeCache(const std::string &cacheFile, const Stamp &stamp, const std::vector<std::string> &mtllibs) const;
+
+    std::unique_ptr<Bytes> cacheBytes;
+    std::vector<tinyobj::shape_t> parsed;
+    std::vector<CachedMesh> shapes;
+    bool fromCache = false;
+};
+
+#endif // LAB471_MESHCACHE_H_INCLUDED
@@ -10,6 +10,7 @@
 #include "Program.h"
 #include "MatrixStack.h"
 #include "Shape.h"
+#include "MeshCache.h"
 #include "Texture.h"
 #include "WindowManager.h"
 #include "particleSys.h"
@@ -180,11 +181,11 @@ public:
         //  Initialize mesh
         //  Load geometry
         //  Some obj files contain material information.We'll ignore them for this assignment.
-        vector<tinyobj::shape_t> TOshapes;
+        MeshCache cache;
         vector<tinyobj::material_t> objMaterials;
         string errStr;
         // load in the mesh and make the shape(s)
-        bool rc = tinyobj::LoadObj(TOshapes, objMaterials, errStr, (resourceDirectory + "/SmoothSphere.obj").c_str());
+        bool rc = cache.load(resourceDirectory + "/SmoothSphere.obj", objMaterials, errStr);
         if (!rc)
         {
             cerr << errStr << endl;
@@ -192,8 +193,7 @@ public:
         else
         {
             sphere = make_shared<Shape>();
-            sphere->createShape(TOshapes[0]);
-            sphere->measure();
+            sphere->createShape(cache.getShapes()[0]);
             sphere->init();
         }
         // read out information stored in the shape about its size - something like this...
@@ -204,22 +204,21 @@ public:
     vector<shared_ptr<Shape>> loadMultModel(const std::string &filename, const std::string &resourceDirectory)
     {
         vector<shared_ptr<Shape>> model;
-        vector<tinyobj::shape_t> TOshapes;
+        MeshCache cache;
         vector<tinyobj::material_t> objMaterials;
         string errStr;
 
-        bool rc = tinyobj::LoadObj(TOshapes, objMaterials, errStr, (resourceDirectory + filename).c_str());
+        bool rc = cache.load(resourceDirectory + filename, objMaterials, errStr);
         if (!rc)
         {
             cerr << "Failed to load " << filename << ": " << errStr << endl;
             return model;
         }
 
-        for (auto &TOshape : TOshapes)
+        for (const CachedMesh &mesh : cache.getShapes())
         {
             auto shape = make_shared<Shape>();
-            shape->createShape(TOshape);
-            shape->measure();
+            shape->createShape(mesh);
             shape->init();
             model.push_back(shape);
         }
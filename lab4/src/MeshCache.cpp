@@ -0,0 +1,351 @@
+#include "MeshCache.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <istream>
+#include <sys/stat.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MESHCACHE_USE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+    // bump the version whenever the layout or the loader's output changes
+    const char CACHE_MAGIC[8] = {'O', 'B', 'J', 'C', 'A', 'C', 'H', 'E'};
+    const uint32_t CACHE_VERSION = 1;
+
+    // The start of a cache file. It is followed by the material library
+    // names, then every shape: its name, array sizes, bounds and arrays.
+    // Every field starts on an 8 byte boundary.
+    struct CacheHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t numShapes;
+        uint64_t objSize;
+        int64_t objTime;
+        uint64_t objHash;
+        uint64_t numMtllibs;
+    };
+
+    size_t padded(size_t bytes)
+    {
+        return (bytes + 7) & ~static_cast<size_t>(7);
+    }
+
+    // FNV-1a over 64 bit words, folding the high bits down after each one
+    uint64_t hashBytes(const char *data, size_t size)
+    {
+        uint64_t h = 14695981039346656037ull;
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8)
+        {
+            uint64_t word;
+            memcpy(&word, data + i, sizeof(word));
+            h = (h ^ word) * 1099511628211ull;
+            h ^= h >> 29;
+        }
+        for (; i < size; i++)
+            h = (h ^ static_cast<unsigned char>(data[i])) * 1099511628211ull;
+        return h ^ size;
+    }
+
+    // Loads material libraries like tinyobj does and remembers their names,
+    // so that a cache hit can load them again
+    class RecordingMaterialReader : public tinyobj::MaterialReader
+    {
+    public:
+        RecordingMaterialReader() : reader("") {}
+
+        bool operator()(const std::string &matId, std::vector<tinyobj::material_t> &materials,
+                        std::map<std::string, int> &matMap, std::string &err) override
+        {
+            mtllibs.push_back(matId);
+            return reader(matId, materials, matMap, err);
+        }
+
+        std::vector<std::string> mtllibs;
+
+    private:
+        tinyobj::MaterialFileReader reader;
+    };
+
+    // Walks the bytes of a cache file, failing instead of reading past the end
+    class CacheReader
+    {
+    public:
+        CacheReader(const char *data, size_t size) : data(data), size(size) {}
+
+        // the next count elements of T, or nullptr if the file is too short
+        template <typename T>
+        const T *next(size_t count)
+        {
+            if (count > (size - offset) / sizeof(T))
+                return nullptr;
+            const T *p = reinterpret_cast<const T *>(data + offset);
+            offset = min(size, offset + padded(count * sizeof(T)));
+            return p;
+        }
+
+    private:
+        const char *data;
+        size_t size;
+        size_t offset = 0;
+    };
+
+    // Reads an istream straight out of memory, without copying it
+    class MemoryStreamBuf : public std::streambuf
+    {
+    public:
+        MemoryStreamBuf(const char *data, size_t size)
+        {
+            char *p = const_cast<char *>(data);
+            setg(p, p, p + size);
+        }
+    };
+
+    void writeBlock(ofstream &out, const void *data, size_t bytes)
+    {
+        static const char zeros[8] = {0};
+        if (bytes > 0)
+            out.write(static_cast<const char *>(data), bytes);
+        out.write(zeros, padded(bytes) - bytes);
+    }
+}
+
+// A whole file, memory mapped where the platform allows it and read into a
+// buffer otherwise
+class MeshCache::Bytes
+{
+public:
+    ~Bytes()
+    {
+#ifdef MESHCACHE_USE_MMAP
+        if (map)
+            munmap(map, length);
+#endif
+    }
+
+    bool open(const string &fileName)
+    {
+#ifdef MESHCACHE_USE_MMAP
+        int fd = ::open(fileName.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat sb;
+        if (fstat(fd, &sb) == 0 && S_ISREG(sb.st_mode) && sb.st_size > 0)
+        {
+            void *p = mmap(nullptr, static_cast<size_t>(sb.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED)
+            {
+                map = p;
+                length = static_cast<size_t>(sb.st_size);
+                close(fd);
+                return true;
+            }
+        }
+        close(fd);
+#endif
+        ifstream in(fileName, ios::binary);
+        if (!in)
+            return false;
+        buffer.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+        length = buffer.size();
+        return true;
+    }
+
+    const char *data() const { return map ? static_cast<const char *>(map) : buffer.data(); }
+    size_t size() const { return length; }
+
+private:
+    void *map = nullptr;
+    size_t length = 0;
+    vector<char> buffer;
+};
+
+MeshCache::MeshCache() {}
+
+MeshCache::~MeshCache() {}
+
+bool MeshCache::load(const string &objFile, vector<tinyobj::material_t> &materials, string &err)
+{
+    shapes.clear();
+    parsed.clear();
+    cacheBytes.reset();
+    fromCache = false;
+
+    struct stat sb;
+    Bytes obj;
+    if (stat(objFile.c_str(), &sb) != 0 || !obj.open(objFile))
+    {
+        err = "Cannot open file [" + objFile + "]\n";
+        return false;
+    }
+    Stamp stamp = {obj.size(), static_cast<long long>(sb.st_mtime), hashBytes(obj.data(), obj.size())};
+
+    string cacheFile = objFile + ".cache";
+    if (readCache(cacheFile, stamp, materials, err))
+    {
+        fromCache = true;
+        return true;
+    }
+
+    // parse the bytes already in memory, recording the material libraries
+    MemoryStreamBuf buf(obj.data(), obj.size());
+    istream in(&buf);
+    RecordingMaterialReader reader;
+    if (!tinyobj::LoadObj(parsed, materials, err, in, reader))
+        return false;
+
+    for (const tinyobj::shape_t &shape : parsed)
+    {
+        const tinyobj::mesh_t &mesh = shape.mesh;
+        CachedMesh view = {shape.name,
+                           mesh.positions.data(), mesh.positions.size(),
+                           mesh.normals.data(), mesh.normals.size(),
+                           mesh.texcoords.data(), mesh.texcoords.size(),
+                           mesh.indices.data(), mesh.indices.size(),
+                           mesh.material_ids.data(), mesh.material_ids.size(),
+                           {numeric_limits<float>::max(), numeric_limits<float>::max(), numeric_limits<float>::max()},
+                           {-numeric_limits<float>::max(), -numeric_limits<float>::max(), -numeric_limits<float>::max()}};
+        for (size_t i = 0; i < mesh.positions.size(); i++)
+        {
+            view.min[i % 3] = std::min(view.min[i % 3], mesh.positions[i]);
+            view.max[i % 3] = std::max(view.max[i % 3], mesh.positions[i]);
+        }
+        shapes.push_back(view);
+    }
+
+    writeCache(cacheFile, stamp, reader.mtllibs);
+    return true;
+}
+
+bool MeshCache::readCache(const string &cacheFile, const Stamp &stamp, vector<tinyobj::material_t> &materials,
+                          string &err)
+{
+    unique_ptr<Bytes> bytes(new Bytes());
+    if (!bytes->open(cacheFile))
+        return false;
+
+    CacheReader reader(bytes->data(), bytes->size());
+    const CacheHeader *header = reader.next<CacheHeader>(1);
+    if (!header || memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+        header->version != CACHE_VERSION || header->objSize != stamp.size || header->objTime != stamp.time ||
+        header->objHash != stamp.hash)
+        return false;
+
+    vector<string> mtllibs;
+    for (uint64_t i = 0; i < header->numMtllibs; i++)
+    {
+        const uint64_t *length = reader.next<uint64_t>(1);
+        const char *name = length ? reader.next<char>(*length) : nullptr;
+        if (!name)
+            return false;
+        mtllibs.push_back(string(name, *length));
+    }
+
+    vector<CachedMesh> views;
+    for (uint32_t i = 0; i < header->numShapes; i++)
+    {
+        const uint64_t *length = reader.next<uint64_t>(1);
+        const char *name = length ? reader.next<char>(*length) : nullptr;
+        const uint64_t *counts = name ? reader.next<uint64_t>(5) : nullptr;
+        const float *bounds = counts ? reader.next<float>(6) : nullptr;
+        if (!bounds)
+            return false;
+
+        CachedMesh view;
+        view.name = string(name, *length);
+        view.numPositions = counts[0];
+        view.numNormals = counts[1];
+        view.numTexcoords = counts[2];
+        view.numIndices = counts[3];
+        view.numMaterialIds = counts[4];
+        view.positions = reader.next<float>(view.numPositions);
+        view.normals = reader.next<float>(view.numNormals);
+        view.texcoords = reader.next<float>(view.numTexcoords);
+        view.indices = reader.next<unsigned int>(view.numIndices);
+        view.materialIds = reader.next<int>(view.numMaterialIds);
+        if (!view.positions || !view.normals || !view.texcoords || !view.indices || !view.materialIds)
+            return false;
+        memcpy(view.min, bounds, sizeof(view.min));
+        memcpy(view.max, bounds + 3, sizeof(view.max));
+        views.push_back(view);
+    }
+
+    // the materials come from the .mtl files as they are now
+    tinyobj::MaterialFileReader matReader("");
+    map<string, int> matMap;
+    for (const string &mtllib : mtllibs)
+        matReader(mtllib, materials, matMap, err);
+
+    shapes.swap(views);
+    cacheBytes = move(bytes);
+    return true;
+}
+
+void MeshCache::writeCache(const string &cacheFile, const Stamp &stamp, const vector<string> &mtllibs) const
+{
+    // write to a temporary file and rename it, so no one maps half a cache
+    string tempFile = cacheFile + ".tmp";
+    {
+        ofstream out(tempFile, ios::binary);
+        if (!out)
+            return;
+
+        CacheHeader header;
+        memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        header.version = CACHE_VERSION;
+        header.numShapes = static_cast<uint32_t>(shapes.size());
+        header.objSize = stamp.size;
+        header.objTime = stamp.time;
+        header.objHash = stamp.hash;
+        header.numMtllibs = mtllibs.size();
+        writeBlock(out, &header, sizeof(header));
+
+        for (const string &mtllib : mtllibs)
+        {
+            uint64_t length = mtllib.size();
+            writeBlock(out, &length, sizeof(length));
+            writeBlock(out, mtllib.data(), mtllib.size());
+        }
+
+        for (const CachedMesh &view : shapes)
+        {
+            uint64_t length = view.name.size();
+            uint64_t counts[5] = {view.numPositions, view.numNormals, view.numTexcoords, view.numIndices,
+                                  view.numMaterialIds};
+            float bounds[6] = {view.min[0], view.min[1], view.min[2], view.max[0], view.max[1], view.max[2]};
+            writeBlock(out, &length, sizeof(length));
+            writeBlock(out, view.name.data(), view.name.size());
+            writeBlock(out, counts, sizeof(counts));
+            writeBlock(out, bounds, sizeof(bounds));
+            writeBlock(out, view.positions, view.numPositions * sizeof(float));
+            writeBlock(out, view.normals, view.numNormals * sizeof(float));
+            writeBlock(out, view.texcoords, view.numTexcoords * sizeof(float));
+            writeBlock(out, view.indices, view.numIndices * sizeof(unsigned int));
+            writeBlock(out, view.materialIds, view.numMaterialIds * sizeof(int));
+        }
+
+        if (!out)
+        {
+            out.close();
+            remove(tempFile.c_str());
+            return;
+        }
+    }
+    // rename does not replace an existing file everywhere
+    remove(cacheFile.c_str());
+    if (rename(tempFile.c_str(), cacheFile.c_str()) != 0)
+        remove(tempFile.c_str());
+}
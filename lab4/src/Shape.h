@@ -9,6 +9,7 @@
 #include <tiny_obj_loader/tiny_obj_loader.h>
 
 class Program;
+struct CachedMesh;
 
 class Shape
 {
@@ -16,6 +17,7 @@ public:
 	Shape();
 	virtual ~Shape();
 	void createShape(tinyobj::shape_t & shape);
+	void createShape(const CachedMesh & mesh);
 	void init();
 	void measure();
 	void draw(const std::shared_ptr<Program> prog) const;
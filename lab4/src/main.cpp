@@ -10,6 +10,7 @@
 #include "GLSL.h"
 #include "Program.h"
 #include "Shape.h"
+#include "MeshCache.h"
 #include "MatrixStack.h"
 #include "WindowManager.h"
 
@@ -235,11 +236,11 @@ public:
         //  Initialize mesh
         //  Load geometry
         //  Some obj files contain material information.We'll ignore them for this assignment.
-        vector<tinyobj::shape_t> TOshapes;
+        MeshCache cache;
         vector<tinyobj::material_t> objMaterials;
         string errStr;
         // load in the mesh and make the shape(s)
-        bool rc = tinyobj::LoadObj(TOshapes, objMaterials, errStr, (resourceDirectory + "/cube.obj").c_str());
+        bool rc = cache.load(resourceDirectory + "/cube.obj", objMaterials, errStr);
         if (!rc)
         {
             cerr << errStr << endl;
@@ -247,8 +248,7 @@ public:
         else
         {
             mesh = make_shared<Shape>();
-            mesh->createShape(TOshapes[0]);
-            mesh->measure();
+            mesh->createShape(cache.getShapes()[0]);
             mesh->init();
         }
         // read out information stored in the shape about its size - something like this...
@@ -11,6 +11,7 @@
 #include <tiny_obj_loader/tiny_obj_loader.h>
 
 class Program;
+struct CachedMesh;
 
 
 class Shape
@@ -19,6 +20,7 @@ class Shape
 public:
 
 	void createShape(tinyobj::shape_t & shape);
+	void createShape(const CachedMesh & mesh);
 	void init();
 	void measure();
 	void draw(const std::shared_ptr<Program> prog) const;
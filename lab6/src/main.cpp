@@ -10,6 +10,7 @@
 #include "GLSL.h"
 #include "Program.h"
 #include "Shape.h"
+#include "MeshCache.h"
 #include "MatrixStack.h"
 #include "WindowManager.h"
 #include "Texture.h"
@@ -200,11 +201,11 @@ public:
         //  Initialize mesh
         //  Load geometry
         //  Some obj files contain material information.We'll ignore them for this assignment.
-        vector<tinyobj::shape_t> TOshapes;
+        MeshCache cache;
         vector<tinyobj::material_t> objMaterials;
         string errStr;
         // load in the mesh and make the shape(s)
-        bool rc = tinyobj::LoadObj(TOshapes, objMaterials, errStr, (resourceDirectory + "/sphereWTex.obj").c_str());
+        bool rc = cache.load(resourceDirectory + "/sphereWTex.obj", objMaterials, errStr);
         if (!rc)
         {
             cerr << errStr << endl;
@@ -212,8 +213,7 @@ public:
         else
         {
             sphere = make_shared<Shape>();
-            sphere->createShape(TOshapes[0]);
-            sphere->measure();
+            sphere->createShape(cache.getShapes()[0]);
             sphere->init();
         }
         // read out information stored in the shape about its size - something like this...
@@ -222,10 +222,10 @@ public:
         gMin.y = sphere->min.y;
 
         // Initialize bunny mesh.
-        vector<tinyobj::shape_t> TOshapesB;
+        MeshCache cacheB;
         vector<tinyobj::material_t> objMaterialsB;
         // load in the mesh and make the shape(s)
-        rc = tinyobj::LoadObj(TOshapesB, objMaterialsB, errStr, (resourceDirectory + "/dog.obj").c_str());
+        rc = cacheB.load(resourceDirectory + "/dog.obj", objMaterialsB, errStr);
         if (!rc)
         {
             cerr << errStr << endl;
@@ -233,8 +233,7 @@ public:
         else
         {
             theBunny = make_shared<Shape>();
-            theBunny->createShape(TOshapesB[0]);
-            theBunny->measure();
+            theBunny->createShape(cacheB.getShapes()[0]);
             theBunny->init();
         }
 
@@ -11,12 +11,14 @@
 #include <tiny_obj_loader/tiny_obj_loader.h>
 
 class Program;
+struct CachedMesh;
 
 class Shape
 {
 
 public:
     void createShape(tinyobj::shape_t &shape);
+    void createShape(const CachedMesh &mesh);
     void init();
     void measure();
     glm::mat4 getNormalizationMatrix(glm::vec3 min, glm::vec3 max) const;
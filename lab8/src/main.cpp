@@ -10,6 +10,7 @@
 #include "GLSL.h"
 #include "Program.h"
 #include "Shape.h"
+#include "MeshCache.h"
 #include "MatrixStack.h"
 #include "WindowManager.h"
 #include "Texture.h"
@@ -230,11 +231,11 @@ public:
         //  Initialize mesh
         //  Load geometry
         //  Some obj files contain material information.We'll ignore them for this assignment.
-        vector<tinyobj::shape_t> TOshapes;
+        MeshCache cache;
         vector<tinyobj::material_t> objMaterials;
         string errStr;
         // load in the mesh and make the shape(s)
-        bool rc = tinyobj::LoadObj(TOshapes, objMaterials, errStr, (resourceDirectory + "/SmoothSphere.obj").c_str());
+        bool rc = cache.load(resourceDirectory + "/SmoothSphere.obj", objMaterials, errStr);
         if (!rc)
         {
             cerr << errStr << endl;
@@ -242,8 +243,7 @@ public:
         else
         {
             sphere = make_shared<Shape>();
-            sphere->createShape(TOshapes[0]);
-            sphere->measure();
+            sphere->createShape(cache.getShapes()[0]);
             sphere->init();
         }
         // read out information stored in the shape about its size - something like this...
@@ -256,22 +256,21 @@ public:
             vector<shared_ptr<Shape>> shapesVec;
             vector<shared_ptr<pair<vec3, vec3>>> minMaxVec;
 
-            vector<tinyobj::shape_t> shapes;
+            MeshCache cache;
             vector<tinyobj::material_t> materials;
             string errStr;
 
-            bool rc = tinyobj::LoadObj(shapes, materials, errStr, (resourceDirectory + "/" + filename).c_str());
+            bool rc = cache.load(resourceDirectory + "/" + filename, materials, errStr);
             if (!rc)
             {
                 cerr << "Failed to load " << filename << ": " << errStr << endl;
                 return {shapesVec, minMaxVec};
             }
 
-            for (auto &shape : shapes)
+            for (const CachedMesh &shape : cache.getShapes())
             {
                 auto mesh = make_shared<Shape>();
                 mesh->createShape(shape);
-                mesh->measure();
                 mesh->init();
 
                 shapesVec.push_back(mesh);
@@ -300,9 +299,9 @@ public:
         bulbasaurMeshes = bulbasaurData.first;
         bulbasaurMinsMaxs = bulbasaurData.second;
 
-        vector<tinyobj::shape_t> TOshapesC;
+        MeshCache cacheC;
         vector<tinyobj::material_t> objMaterialsC;
-        rc = tinyobj::LoadObj(TOshapesC, objMaterialsC, errStr, (resourceDirectory + "/icoNoNormals.obj").c_str());
+        rc = cacheC.load(resourceDirectory + "/icoNoNormals.obj", objMaterialsC, errStr);
         if (!rc)
         {
             cerr << errStr << endl;
@@ -310,8 +309,7 @@ public:
         else
         {
             noNormals = make_shared<Shape>();
-            noNormals->createShape(TOshapesC[0]);
-            noNormals->measure();
+            noNormals->createShape(cacheC.getShapes()[0]);
             noNormals->init();
         }
 
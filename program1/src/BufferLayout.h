@@ -0,0 +1,86 @@
+#ifndef BUFFER_LAYOUT_H
+#define BUFFER_LAYOUT_H
+
+#include <cstddef>
+
+/* Width and height of a tile of the tiled layout in pixels */
+const int LAYOUT_TILE_SIZE = 8;
+
+/*
+    How the pixels of a color or depth buffer are ordered in memory.
+    LAYOUT_ROWS is plain row-major. LAYOUT_TILED stores the buffer as
+    LAYOUT_TILE_SIZE x LAYOUT_TILE_SIZE tiles, one after another in row-major
+    tile order, each tile row-major inside. An 8 x 8 raster block then covers
+    one contiguous run of memory instead of 8 rows far apart.
+*/
+enum BufferLayout
+{
+    LAYOUT_ROWS,
+    LAYOUT_TILED
+};
+
+/*
+    Maps pixel coordinates to an element index for one layout. Either way the
+    pixels from x up to the end of its tile column (x | 7) are contiguous.
+    Tiled buffers are padded to whole tiles.
+*/
+class PixelLayout
+{
+public:
+    PixelLayout(BufferLayout layout, int width, int height) :
+        m_layout(layout),
+        m_width(width),
+        m_height(height),
+        m_tilesX((width + LAYOUT_TILE_SIZE - 1) / LAYOUT_TILE_SIZE),
+        m_tilesY((height + LAYOUT_TILE_SIZE - 1) / LAYOUT_TILE_SIZE)
+    {
+    }
+
+    BufferLayout getLayout() const { return m_layout; }
+
+    // number of elements the buffer needs, including padding
+    size_t getSize() const
+    {
+        if (m_layout == LAYOUT_TILED)
+            return size_t(m_tilesX) * m_tilesY * LAYOUT_TILE_SIZE * LAYOUT_TILE_SIZE;
+        return size_t(m_width) * m_height;
+    }
+
+    size_t offset(int x, int y) const
+    {
+        if (m_layout == LAYOUT_TILED)
+        {
+            size_t tile = size_t(y / LAYOUT_TILE_SIZE) * m_tilesX + x / LAYOUT_TILE_SIZE;
+            return tile * LAYOUT_TILE_SIZE * LAYOUT_TILE_SIZE + (y % LAYOUT_TILE_SIZE) * LAYOUT_TILE_SIZE +
+                   x % LAYOUT_TILE_SIZE;
+        }
+        return size_t(y) * m_width + x;
+    }
+
+    /*
+        Copy a buffer in this layout to row-major order, comp elements per
+        pixel. With flipY the rows come out in reverse order.
+    */
+    template <class T>
+    void toRows(const T *in, T *out, int comp, bool flipY) const
+    {
+        for (int y = 0; y < m_height; y++)
+        {
+            T *row = out + size_t(flipY ? m_height - 1 - y : y) * m_width * comp;
+            for (int x = 0; x < m_width; x += LAYOUT_TILE_SIZE)
+            {
+                int count = x + LAYOUT_TILE_SIZE <= m_width ? LAYOUT_TILE_SIZE : m_width - x;
+                const T *span = in + offset(x, y) * comp;
+                for (int i = 0; i < count * comp; i++)
+                    row[x * comp + i] = span[i];
+            }
+        }
+    }
+
+private:
+    BufferLayout m_layout;
+    int m_width, m_height;
+    int m_tilesX, m_tilesY;
+};
+
+#endif
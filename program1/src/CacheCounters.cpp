@@ -0,0 +1,112 @@
+#include "CacheCounters.h"
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static int openEvent(unsigned int type, unsigned long long config)
+{
+	perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = type;
+	attr.config = config;
+	attr.disabled = 1;
+	attr.inherit = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+static unsigned long long cacheConfig(unsigned long long cache)
+{
+	return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+CacheCounters::CacheCounters() :
+	m_available(true)
+{
+	m_fds[CACHE_L1D_MISSES] = openEvent(PERF_TYPE_HW_CACHE, cacheConfig(PERF_COUNT_HW_CACHE_L1D));
+	m_fds[CACHE_LLC_MISSES] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+	m_fds[CACHE_DTLB_MISSES] = openEvent(PERF_TYPE_HW_CACHE, cacheConfig(PERF_COUNT_HW_CACHE_DTLB));
+	for(int i = 0; i < CACHE_EVENT_COUNT; i++) {
+		m_available = m_available && m_fds[i] >= 0;
+	}
+}
+
+CacheCounters::~CacheCounters()
+{
+	for(int i = 0; i < CACHE_EVENT_COUNT; i++) {
+		if(m_fds[i] >= 0) {
+			close(m_fds[i]);
+		}
+	}
+}
+
+void CacheCounters::start()
+{
+	if(!m_available) {
+		return;
+	}
+	for(int i = 0; i < CACHE_EVENT_COUNT; i++) {
+		ioctl(m_fds[i], PERF_EVENT_IOC_RESET, 0);
+		ioctl(m_fds[i], PERF_EVENT_IOC_ENABLE, 0);
+	}
+}
+
+void CacheCounters::stop()
+{
+	if(!m_available) {
+		return;
+	}
+	for(int i = 0; i < CACHE_EVENT_COUNT; i++) {
+		ioctl(m_fds[i], PERF_EVENT_IOC_DISABLE, 0);
+	}
+}
+
+long long CacheCounters::getCount(CacheEvent event) const
+{
+	long long count = 0;
+	if(!m_available || read(m_fds[event], &count, sizeof(count)) != sizeof(count)) {
+		return -1;
+	}
+	return count;
+}
+
+#else
+
+CacheCounters::CacheCounters() :
+	m_available(false)
+{
+}
+
+CacheCounters::~CacheCounters()
+{
+}
+
+void CacheCounters::start()
+{
+}
+
+void CacheCounters::stop()
+{
+}
+
+long long CacheCounters::getCount(CacheEvent) const
+{
+	return -1;
+}
+
+#endif
+
+const char *getCacheEventName(CacheEvent event)
+{
+	switch(event) {
+		case CACHE_L1D_MISSES: return "L1d misses";
+		case CACHE_LLC_MISSES: return "LLC misses";
+		default: return "dTLB misses";
+	}
+}
@@ -0,0 +1,43 @@
+#ifndef CACHE_COUNTERS_H
+#define CACHE_COUNTERS_H
+
+/* The events counted, in the order getCount takes them */
+enum CacheEvent
+{
+    CACHE_L1D_MISSES,  // L1 data cache read misses
+    CACHE_LLC_MISSES,  // last level cache misses
+    CACHE_DTLB_MISSES, // data TLB read misses
+    CACHE_EVENT_COUNT
+};
+
+/*
+    Hardware cache miss counters, read with perf_event_open on Linux.
+    They count the thread that created them and every thread it starts after
+    that, so create them before the workers are spawned. Counts of a worker
+    are only added once it has exited.
+    On other systems, in VMs without performance counters, or when
+    perf_event_paranoid forbids it the counters are simply not available.
+*/
+class CacheCounters
+{
+public:
+    CacheCounters();
+    ~CacheCounters();
+
+    bool isAvailable() const { return m_available; }
+    // zero and start every counter
+    void start();
+    void stop();
+    long long getCount(CacheEvent event) const;
+
+private:
+    CacheCounters(const CacheCounters &);
+    CacheCounters &operator=(const CacheCounters &);
+
+    int m_fds[CACHE_EVENT_COUNT];
+    bool m_available;
+};
+
+const char *getCacheEventName(CacheEvent event);
+
+#endif
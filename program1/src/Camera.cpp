@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include "Camera.h"
+
+using namespace std;
+
+bool parseMatrix(const string &text, Mat4 &out)
+{
+	string spaced(text);
+	replace(spaced.begin(), spaced.end(), ',', ' ');
+	istringstream in(spaced);
+	for(int i = 0; i < 16; i++) {
+		if(!(in >> out.m[i / 4][i % 4])) {
+			return false;
+		}
+	}
+	string rest;
+	return !(in >> rest);
+}
+
+static bool readVec3(istringstream &in, Vec3 &v)
+{
+	float x, y, z;
+	if(!(in >> x >> y >> z)) {
+		return false;
+	}
+	v = Vec3(x, y, z);
+	return true;
+}
+
+bool loadCamera(const string &filename, Camera &camera, string &err)
+{
+	ifstream file(filename);
+	if(!file) {
+		err = "Cannot open camera file " + filename;
+		return false;
+	}
+
+	string line;
+	int lineNumber = 0;
+	while(getline(file, line)) {
+		lineNumber++;
+		line = line.substr(0, line.find('#'));
+		istringstream in(line);
+		string key;
+		if(!(in >> key)) {
+			continue;
+		}
+
+		bool ok;
+		if(key == "eye") {
+			ok = readVec3(in, camera.eye);
+		} else if(key == "target") {
+			ok = readVec3(in, camera.target);
+		} else if(key == "up") {
+			ok = readVec3(in, camera.up);
+		} else if(key == "fovy") {
+			ok = static_cast<bool>(in >> camera.fovy);
+		} else if(key == "near") {
+			ok = static_cast<bool>(in >> camera.zNear);
+		} else if(key == "far") {
+			ok = static_cast<bool>(in >> camera.zFar);
+		} else if(key == "matrix") {
+			string rest;
+			getline(in, rest);
+			ok = parseMatrix(rest, camera.matrix);
+			camera.hasMatrix = ok;
+		} else {
+			ok = false;
+		}
+		if(!ok) {
+			err = filename + ":" + to_string(lineNumber) + ": cannot parse '" + line + "'";
+			return false;
+		}
+	}
+	return true;
+}
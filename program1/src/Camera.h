@@ -0,0 +1,48 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include <string>
+#include "Mat4.h"
+
+/*
+    A view of the mesh. The mesh has already been resized to [-1, 1], so the
+    camera works in those units. Either a full model-view-projection matrix is
+    given directly, or it is built from a look-at view and a perspective
+    projection.
+*/
+struct Camera
+{
+    Camera() : hasMatrix(false), eye(0, 0, 3), target(0, 0, 0), up(0, 1, 0), fovy(45), zNear(0.1f), zFar(100) {}
+
+    bool hasMatrix;
+    Mat4 matrix;
+
+    Vec3 eye, target, up;
+    float fovy;
+    float zNear, zFar;
+
+    Mat4 getMVP(float aspect) const
+    {
+        if (hasMatrix)
+            return matrix;
+        return Mat4::perspective(fovy, aspect, zNear, zFar) * Mat4::lookAt(eye, target, up);
+    }
+};
+
+/* Parse 16 row-major numbers separated by commas or spaces */
+bool parseMatrix(const std::string &text, Mat4 &out);
+
+/*
+    Read a camera file. Each line is a keyword followed by numbers, # starts
+    a comment:
+        eye x y z
+        target x y z
+        up x y z
+        fovy degrees
+        near distance
+        far distance
+        matrix m00 m01 ... m33   (row-major, overrides everything else)
+*/
+bool loadCamera(const std::string &filename, Camera &camera, std::string &err);
+
+#endif
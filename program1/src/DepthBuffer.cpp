@@ -0,0 +1,65 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include "DepthBuffer.h"
+#include "ImageWriter.h"
+
+using namespace std;
+
+DepthBuffer::DepthBuffer(int width, int height, BufferLayout layout) :
+	m_width(width),
+	m_height(height),
+	m_tilesX((width + HIZ_TILE_SIZE - 1) / HIZ_TILE_SIZE),
+	m_tilesY((height + HIZ_TILE_SIZE - 1) / HIZ_TILE_SIZE),
+	m_originY(0),
+	m_layout(layout, width, height),
+	m_depth(m_layout.getSize(), -numeric_limits<float>::infinity()),
+	m_tileFar(m_tilesX * m_tilesY, -numeric_limits<float>::infinity())
+{
+}
+
+void DepthBuffer::updateTileFar(int tx, int ty)
+{
+	// from here on rows are rows of the buffer, not of the picture
+	ty -= m_originY / HIZ_TILE_SIZE;
+	int x0 = tx * HIZ_TILE_SIZE, x1 = min(x0 + HIZ_TILE_SIZE, m_width);
+	int y0 = ty * HIZ_TILE_SIZE, y1 = min(y0 + HIZ_TILE_SIZE, m_height);
+	float farthest = numeric_limits<float>::infinity();
+	for(int y = y0; y < y1; y++) {
+		// padding past the image edge is never drawn, so it is left out
+		const float *span = &m_depth[m_layout.offset(x0, y)];
+		for(int x = 0; x < x1 - x0; x++) {
+			farthest = min(farthest, span[x]);
+		}
+	}
+	m_tileFar[ty * m_tilesX + tx] = farthest;
+}
+
+void DepthBuffer::clear()
+{
+	fill(m_depth.begin(), m_depth.end(), -numeric_limits<float>::infinity());
+	fill(m_tileFar.begin(), m_tileFar.end(), -numeric_limits<float>::infinity());
+}
+
+void DepthBuffer::writeToFile(const string &filename) const
+{
+	// rows are stored bottom row first, like PFM wants them, but tiles have
+	// to be put back into rows. Pixels nothing was drawn on keep their -infinity.
+	auto start = chrono::steady_clock::now();
+	const float *values = &m_depth[0];
+	vector<float> rows;
+	if(m_layout.getLayout() == LAYOUT_TILED) {
+		rows.resize(size_t(m_width) * m_height);
+		m_layout.toRows(&m_depth[0], &rows[0], 1, false);
+		values = &rows[0];
+	}
+	size_t bytes = writePFM(filename, values, m_width, m_height);
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	if(bytes) {
+		double megabytes = size_t(m_width) * m_height * sizeof(float) / 1e6;
+		cout << "Wrote depth to " << filename << " (pfm, " << bytes / 1e6 << " MB, " << megabytes / seconds << " MB/s)" << endl;
+	} else {
+		cout << "Couldn't write to " << filename << endl;
+	}
+}
@@ -0,0 +1,53 @@
+#ifndef DEPTH_BUFFER_H
+#define DEPTH_BUFFER_H
+
+#include <string>
+#include <vector>
+#include "BufferLayout.h"
+
+/* Width and height of a hierarchical z tile in pixels */
+const int HIZ_TILE_SIZE = 8;
+
+/*
+    Two level depth buffer. The fine level holds one depth per pixel, larger z
+    is closer. The coarse level holds the farthest (smallest) depth of every
+    HIZ_TILE_SIZE x HIZ_TILE_SIZE tile, so a triangle whose nearest depth is
+    behind it cannot pass the depth test anywhere in that tile.
+    Depth only ever moves closer, so a coarse value that has not been refreshed
+    after a write is still a safe (too far) bound.
+    The fine level is row-major or tiled (see BufferLayout.h); rows start at
+    the bottom of the image either way.
+*/
+class DepthBuffer
+{
+public:
+    DepthBuffer(int width, int height, BufferLayout layout = LAYOUT_ROWS);
+
+    int getWidth() const { return m_width; }
+    int getHeight() const { return m_height; }
+
+    // the depths from x to the end of its 8 pixel tile column are contiguous
+    float *getSpan(int x, int y) { return &m_depth[m_layout.offset(x, y - m_originY)]; }
+    float &at(int x, int y) { return m_depth[m_layout.offset(x, y - m_originY)]; }
+
+    float getTileFar(int tx, int ty) const { return m_tileFar[(ty - m_originY / HIZ_TILE_SIZE) * m_tilesX + tx]; }
+    void updateTileFar(int tx, int ty);
+
+    // Like Image::setOriginY, row y of the picture is row y - originY of the
+    // buffer. originY must be a multiple of HIZ_TILE_SIZE.
+    void setOriginY(int y) { m_originY = y; }
+
+    void clear();
+    // write the depth of every pixel as a float image (.pfm), bottom row first
+    void writeToFile(const std::string &filename) const;
+
+private:
+    int m_width, m_height;
+    int m_tilesX, m_tilesY;
+    int m_originY;
+    PixelLayout m_layout;
+    std::vector<float> m_depth;
+    std::vector<float> m_tileFar;
+};
+
+#endif
@@ -1,18 +1,24 @@
+#include <algorithm>
+#include <chrono>
 #include <iostream>
-#include <cassert>
 #include "Image.h"
+#include "ImageWriter.h"
 
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb_image_write.h"
 
 using namespace std;
 
-Image::Image(int w, int h) :
+Image::Image(int w, int h, bool topLeftOrigin, BufferLayout bufferLayout) :
 	width(w),
 	height(h),
 	comp(3),
-	pixels(width*height*comp, 0)
+	topLeft(topLeftOrigin),
+	rowStep(topLeftOrigin || bufferLayout == LAYOUT_TILED ? 1 : -1),
+	layout(bufferLayout, w, h),
+	pixels(layout.getSize()*comp, 0)
 {
+	setOriginY(0);
 }
 
 Image::~Image()
@@ -36,25 +42,74 @@ void Image::setPixel(int x, int y, unsigned char r, unsigned char g, unsigned ch
 
 	// Since the origin (0, 0) of the image is the upper left corner, we need
 	// to flip the row to make the origin be the lower left corner.
-	y = height - y - 1;
-	// index corresponding to row and col, (assuming single component image)
-	int index = y*width + x;
-	// Multiply by 3 to get the index for the rgb components.
-	assert(index >= 0);
-	assert(3*index + 2 < (int)pixels.size());
-	pixels[3*index + 0] = r;
-	pixels[3*index + 1] = g;
-	pixels[3*index + 2] = b;
-}
-
-void Image::writeToFile(const string &filename)
-{
-	// The distance in bytes from the first byte of a row of pixels to the
-	// first byte of the next row of pixels
-	int stride_in_bytes = width*comp*sizeof(unsigned char);
-	int rc = stbi_write_png(filename.c_str(), width, height, comp, &pixels[0], stride_in_bytes);
-	if(rc) {
-		cout << "Wrote to " << filename << endl;
+	// getSpan does that unless the image was made with a top-left origin.
+	unsigned char *pixel = getSpan(x, y);
+	pixel[0] = r;
+	pixel[1] = g;
+	pixel[2] = b;
+}
+
+void Image::writeSpan(int x, int y, int count, const unsigned char *rgb)
+{
+	// count packed rgb pixels starting at (x, y)
+	copy(rgb, rgb + 3*count, getSpan(x, y));
+}
+
+void Image::writeSpan(int x, int y, int count, const unsigned char *rgb, unsigned int mask)
+{
+	// Bit i of mask selects whether pixel x + i takes its color from rgb.
+	// The select is done with byte masks so there is no branch per pixel.
+	unsigned char *dst = getSpan(x, y);
+	for(int i = 0; i < count; i++) {
+		unsigned char keep = static_cast<unsigned char>(((mask >> i) & 1u) - 1u);
+		dst[3*i + 0] = static_cast<unsigned char>((dst[3*i + 0] & keep) | (rgb[3*i + 0] & ~keep));
+		dst[3*i + 1] = static_cast<unsigned char>((dst[3*i + 1] & keep) | (rgb[3*i + 1] & ~keep));
+		dst[3*i + 2] = static_cast<unsigned char>((dst[3*i + 2] & keep) | (rgb[3*i + 2] & ~keep));
+	}
+}
+
+void Image::readRow(int y, unsigned char *rgb)
+{
+	// a span never crosses a tile column, so copy tile column by tile column
+	for(int x = 0; x < width; x += LAYOUT_TILE_SIZE) {
+		int count = min(LAYOUT_TILE_SIZE, width - x);
+		const unsigned char *span = getSpan(x, y);
+		copy(span, span + 3*count, rgb + 3*x);
+	}
+}
+
+void Image::clear()
+{
+	fill(pixels.begin(), pixels.end(), 0);
+}
+
+void Image::writeToFile(const string &filename, int numThreads)
+{
+	// The encoder is picked from the file extension. Every format expects
+	// rows top row first, which is how row-major images are stored; tiled
+	// images are converted here, the only place that needs the rows.
+	ImageFormat format = formatFromFileName(filename);
+	auto start = chrono::steady_clock::now();
+	const unsigned char *rgb = &pixels[0];
+	vector<unsigned char> rows;
+	if(layout.getLayout() == LAYOUT_TILED) {
+		rows.resize(size_t(width) * height * comp);
+		layout.toRows(&pixels[0], &rows[0], comp, !topLeft);
+		rgb = &rows[0];
+	}
+	size_t bytes = 0;
+	switch(format) {
+		case FORMAT_PPM: bytes = writePPM(filename, rgb, width, height); break;
+		case FORMAT_QOI: bytes = writeQOI(filename, rgb, width, height); break;
+		case FORMAT_PNG: bytes = writePNG(filename, rgb, width, height, numThreads); break;
+		default: break;
+	}
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	if(bytes) {
+		// throughput is measured on the uncompressed pixels
+		double megabytes = size_t(width) * height * comp / 1e6;
+		cout << "Wrote to " << filename << " (" << getFormatName(format) << ", " << bytes / 1e6 << " MB, "
+		     << megabytes / seconds << " MB/s)" << endl;
 	} else {
 		cout << "Couldn't write to " << filename << endl;
 	}
@@ -4,21 +4,48 @@
 
 #include <string>
 #include <vector>
+#include "BufferLayout.h"
 
 class Image
 {
 public:
-	Image(int width, int height);
+	// With topLeftOrigin row 0 is the top row and rows are not flipped.
+	// A tiled image keeps its pixels in 8 x 8 tiles until it is written out.
+	Image(int width, int height, bool topLeftOrigin = false, BufferLayout layout = LAYOUT_ROWS);
 	virtual ~Image();
 	void setPixel(int x, int y, unsigned char r, unsigned char g, unsigned char b);
-	void writeToFile(const std::string &filename);
+
+	// Span access for the rasterizer. These do no bounds checks, callers
+	// clip to the image before they get here. The pixels from x to the end
+	// of its 8 pixel tile column are contiguous, so spans must not cross it.
+	unsigned char *getSpan(int x, int y) { return &pixels[comp * layout.offset(x, storedRow(y))]; }
+	void writeSpan(int x, int y, int count, const unsigned char *rgb);
+	void writeSpan(int x, int y, int count, const unsigned char *rgb, unsigned int mask);
+
+	// Make the image a window of a taller picture: row y of the picture is
+	// row y - originY of the image. Band rendering moves the window upwards.
+	void setOriginY(int y) { rowBase = rowStep < 0 ? height - 1 + y : -y; }
+	// copy row y (picture coordinates) out as packed rgb
+	void readRow(int y, unsigned char *rgb);
+
+	void writeToFile(const std::string &filename, int numThreads = 1);
+	void clear();
 	int getWidth() const { return width; }
 	int getHeight() const { return height; }
+	BufferLayout getLayout() const { return layout.getLayout(); }
 
 private:
+	// Tiles follow the rasterizer's rows, so only row-major storage is
+	// flipped. The flip and the origin are folded into rowBase and rowStep
+	// once, instead of being tested for every span.
+	int storedRow(int y) const { return rowBase + rowStep * y; }
+
 	int width;
 	int height;
 	int comp;
+	bool topLeft;
+	int rowBase, rowStep;
+	PixelLayout layout;
 	std::vector<unsigned char> pixels;
 };
 
@@ -0,0 +1,413 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include "ImageWriter.h"
+#include "Tiles.h"
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#else
+#include "stb_image_write.h"
+#endif
+
+using namespace std;
+
+ImageFormat formatFromFileName(const string &filename)
+{
+	size_t dot = filename.find_last_of('.');
+	string ext = dot == string::npos ? "" : filename.substr(dot + 1);
+	transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(tolower(c)); });
+	if(ext == "ppm") {
+		return FORMAT_PPM;
+	}
+	if(ext == "qoi") {
+		return FORMAT_QOI;
+	}
+	if(ext == "pfm") {
+		return FORMAT_PFM;
+	}
+	return FORMAT_PNG;
+}
+
+const char *getFormatName(ImageFormat format)
+{
+	switch(format) {
+		case FORMAT_PPM: return "ppm";
+		case FORMAT_QOI: return "qoi";
+		case FORMAT_PFM: return "pfm";
+		default: return "png";
+	}
+}
+
+static size_t writeBytes(const string &filename, const vector<unsigned char> &header, const unsigned char *data, size_t size)
+{
+	ofstream file(filename, ios::binary);
+	file.write(reinterpret_cast<const char *>(header.data()), header.size());
+	file.write(reinterpret_cast<const char *>(data), size);
+	return file ? header.size() + size : 0;
+}
+
+static void putBigEndian(vector<unsigned char> &out, uint32_t value)
+{
+	out.push_back(static_cast<unsigned char>(value >> 24));
+	out.push_back(static_cast<unsigned char>(value >> 16));
+	out.push_back(static_cast<unsigned char>(value >> 8));
+	out.push_back(static_cast<unsigned char>(value));
+}
+
+size_t writePPM(const string &filename, const unsigned char *rgb, int width, int height)
+{
+	string header = "P6\n" + to_string(width) + " " + to_string(height) + "\n255\n";
+	return writeBytes(filename, vector<unsigned char>(header.begin(), header.end()), rgb, size_t(width) * height * 3);
+}
+
+size_t writePFM(const string &filename, const float *values, int width, int height)
+{
+	// a negative scale marks little endian data
+	uint16_t probe = 1;
+	bool littleEndian = *reinterpret_cast<unsigned char *>(&probe) == 1;
+	string header = "Pf\n" + to_string(width) + " " + to_string(height) + "\n" + (littleEndian ? "-1.0" : "1.0") + "\n";
+	return writeBytes(filename, vector<unsigned char>(header.begin(), header.end()),
+	                  reinterpret_cast<const unsigned char *>(values), size_t(width) * height * sizeof(float));
+}
+
+/*
+    QOI encoder, see https://qoiformat.org/qoi-specification.pdf
+    Pixels are opaque so alpha never changes and is never written. The index
+    still holds alpha: it starts at (0, 0, 0, 0) like the decoder's, so an
+    empty slot never matches an opaque black pixel.
+*/
+size_t writeQOI(const string &filename, const unsigned char *rgb, int width, int height)
+{
+	const unsigned char OP_INDEX = 0x00, OP_DIFF = 0x40, OP_LUMA = 0x80, OP_RUN = 0xc0, OP_RGB = 0xfe;
+
+	vector<unsigned char> header = {'q', 'o', 'i', 'f'};
+	putBigEndian(header, width);
+	putBigEndian(header, height);
+	header.push_back(3); // channels
+	header.push_back(0); // sRGB
+
+	size_t numPixels = size_t(width) * height;
+	vector<unsigned char> out;
+	out.reserve(numPixels * 4 + 8);
+	unsigned char index[64][4] = {};
+	unsigned char prev[3] = {0, 0, 0};
+	int run = 0;
+	for(size_t p = 0; p < numPixels; p++) {
+		const unsigned char *px = rgb + 3 * p;
+		if(px[0] == prev[0] && px[1] == prev[1] && px[2] == prev[2]) {
+			run++;
+			if(run == 62 || p == numPixels - 1) {
+				out.push_back(OP_RUN | (run - 1));
+				run = 0;
+			}
+			continue;
+		}
+		if(run > 0) {
+			out.push_back(OP_RUN | (run - 1));
+			run = 0;
+		}
+
+		const unsigned char rgba[4] = {px[0], px[1], px[2], 255};
+		int hash = (px[0] * 3 + px[1] * 5 + px[2] * 7 + 255 * 11) % 64;
+		if(memcmp(index[hash], rgba, 4) == 0) {
+			out.push_back(OP_INDEX | hash);
+		} else {
+			memcpy(index[hash], rgba, 4);
+			int dr = static_cast<signed char>(px[0] - prev[0]);
+			int dg = static_cast<signed char>(px[1] - prev[1]);
+			int db = static_cast<signed char>(px[2] - prev[2]);
+			int drg = dr - dg, dbg = db - dg;
+			if(dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+				out.push_back(OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+			} else if(dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7) {
+				out.push_back(OP_LUMA | (dg + 32));
+				out.push_back((drg + 8) << 4 | (dbg + 8));
+			} else {
+				out.push_back(OP_RGB);
+				out.insert(out.end(), px, px + 3);
+			}
+		}
+		memcpy(prev, px, 3);
+	}
+	const unsigned char padding[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+	out.insert(out.end(), padding, padding + 8);
+	return writeBytes(filename, header, out.data(), out.size());
+}
+
+#ifdef HAVE_ZLIB
+
+// zlib level used for every strip, fast rather than small
+static const int PNG_LEVEL = 3;
+// rows per independently compressed strip
+static const int PNG_STRIP_ROWS = 64;
+
+static unsigned char paeth(int a, int b, int c)
+{
+	int p = a + b - c, pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+	if(pa <= pb && pa <= pc) {
+		return static_cast<unsigned char>(a);
+	}
+	return static_cast<unsigned char>(pb <= pc ? b : c);
+}
+
+/*
+    Filter one row with each of the five PNG filters and keep the one with the
+    smallest sum of absolute values, the same heuristic stb_image_write uses.
+    out receives the filter type byte followed by the filtered row.
+*/
+static void filterRow(const unsigned char *row, const unsigned char *above, int rowBytes, unsigned char *out)
+{
+	const int bpp = 3;
+	vector<unsigned char> candidate(rowBytes);
+	long bestSum = -1;
+	for(int type = 0; type < 5; type++) {
+		long sum = 0;
+		for(int i = 0; i < rowBytes; i++) {
+			int a = i >= bpp ? row[i - bpp] : 0;
+			int b = above ? above[i] : 0;
+			int c = i >= bpp && above ? above[i - bpp] : 0;
+			int predicted = 0;
+			switch(type) {
+				case 1: predicted = a; break;
+				case 2: predicted = b; break;
+				case 3: predicted = (a + b) >> 1; break;
+				case 4: predicted = paeth(a, b, c); break;
+			}
+			candidate[i] = static_cast<unsigned char>(row[i] - predicted);
+			sum += abs(static_cast<signed char>(candidate[i]));
+		}
+		if(bestSum < 0 || sum < bestSum) {
+			bestSum = sum;
+			out[0] = static_cast<unsigned char>(type);
+			copy(candidate.begin(), candidate.end(), out + 1);
+		}
+	}
+}
+
+static void putChunk(vector<unsigned char> &png, const char *type, const unsigned char *data, size_t size)
+{
+	putBigEndian(png, static_cast<uint32_t>(size));
+	size_t start = png.size();
+	png.insert(png.end(), type, type + 4);
+	png.insert(png.end(), data, data + size);
+	uLong crc = crc32(0, &png[start], static_cast<uInt>(png.size() - start));
+	putBigEndian(png, static_cast<uint32_t>(crc));
+}
+
+static void putChunk(ofstream &file, const char *type, const unsigned char *data, size_t size)
+{
+	vector<unsigned char> chunk;
+	putChunk(chunk, type, data, size);
+	file.write(reinterpret_cast<const char *>(chunk.data()), chunk.size());
+}
+
+/* Filtered and raw-deflated strips, the output of deflateStrips */
+struct PngStrips
+{
+	vector<vector<unsigned char>> data;
+	vector<uLong> adlers;
+	vector<size_t> filteredSizes;
+};
+
+/*
+    Rows are cut into strips of PNG_STRIP_ROWS. Every strip is filtered and
+    deflated on its own thread into a raw deflate stream; unless finish is set
+    for the last one, they end with a full flush, which leaves them byte
+    aligned and without the final block bit, so they can simply be
+    concatenated. above is the row before the first one, or null for the top
+    row of the image.
+*/
+static bool deflateStrips(const unsigned char *rgb, const unsigned char *above, int width, int numRows, bool finish,
+                          int numThreads, PngStrips &strips)
+{
+	int rowBytes = width * 3;
+	int numStrips = (numRows + PNG_STRIP_ROWS - 1) / PNG_STRIP_ROWS;
+	strips.data.assign(numStrips, vector<unsigned char>());
+	strips.adlers.assign(numStrips, 0);
+	strips.filteredSizes.assign(numStrips, 0);
+	bool ok = true;
+
+	parallelFor(numStrips, numThreads, [&](int s) {
+		int y0 = s * PNG_STRIP_ROWS, y1 = min(y0 + PNG_STRIP_ROWS, numRows);
+		vector<unsigned char> filtered(size_t(y1 - y0) * (rowBytes + 1));
+		for(int y = y0; y < y1; y++) {
+			const unsigned char *row = rgb + size_t(y) * rowBytes;
+			filterRow(row, y > 0 ? row - rowBytes : above, rowBytes, &filtered[size_t(y - y0) * (rowBytes + 1)]);
+		}
+		strips.adlers[s] = adler32(adler32(0, nullptr, 0), filtered.data(), static_cast<uInt>(filtered.size()));
+		strips.filteredSizes[s] = filtered.size();
+
+		z_stream zs;
+		memset(&zs, 0, sizeof(zs));
+		if(deflateInit2(&zs, PNG_LEVEL, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+			ok = false;
+			return;
+		}
+		vector<unsigned char> &out = strips.data[s];
+		out.resize(deflateBound(&zs, static_cast<uLong>(filtered.size())) + 16);
+		zs.next_in = filtered.data();
+		zs.avail_in = static_cast<uInt>(filtered.size());
+		zs.next_out = out.data();
+		zs.avail_out = static_cast<uInt>(out.size());
+		// the last strip has to end the stream, Z_OK there means the output ran out
+		bool last = finish && s == numStrips - 1;
+		int rc = deflate(&zs, last ? Z_FINISH : Z_FULL_FLUSH);
+		if(rc != (last ? Z_STREAM_END : Z_OK)) {
+			ok = false;
+		}
+		out.resize(zs.total_out);
+		deflateEnd(&zs);
+	});
+	return ok;
+}
+
+static void putPngHeader(vector<unsigned char> &png, int width, int height)
+{
+	const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+	png.insert(png.end(), signature, signature + 8);
+	vector<unsigned char> ihdr;
+	putBigEndian(ihdr, width);
+	putBigEndian(ihdr, height);
+	const unsigned char format[5] = {8, 2, 0, 0, 0}; // 8-bit RGB, deflate, adaptive filters, no interlace
+	ihdr.insert(ihdr.end(), format, format + 5);
+	putChunk(png, "IHDR", ihdr.data(), ihdr.size());
+	const unsigned char zlibHeader[2] = {0x78, 0x01};
+	putChunk(png, "IDAT", zlibHeader, 2);
+}
+
+static void putPngTrailer(vector<unsigned char> &png, uLong adler)
+{
+	vector<unsigned char> trailer;
+	putBigEndian(trailer, static_cast<uint32_t>(adler));
+	putChunk(png, "IDAT", trailer.data(), trailer.size());
+	putChunk(png, "IEND", nullptr, 0);
+}
+
+/*
+    The zlib header goes in front of the strips and the Adler-32 of the whole
+    image, combined from the per strip checksums, goes at the end.
+*/
+size_t writePNG(const string &filename, const unsigned char *rgb, int width, int height, int numThreads)
+{
+	PngStrips strips;
+	if(!deflateStrips(rgb, nullptr, width, height, true, numThreads, strips)) {
+		return 0;
+	}
+
+	vector<unsigned char> png;
+	putPngHeader(png, width, height);
+	uLong adler = adler32(0, nullptr, 0);
+	for(size_t s = 0; s < strips.data.size(); s++) {
+		adler = adler32_combine(adler, strips.adlers[s], static_cast<z_off_t>(strips.filteredSizes[s]));
+		putChunk(png, "IDAT", strips.data[s].data(), strips.data[s].size());
+	}
+	putPngTrailer(png, adler);
+
+	return writeBytes(filename, vector<unsigned char>(), png.data(), png.size());
+}
+
+#else
+
+size_t writePNG(const string &filename, const unsigned char *rgb, int width, int height, int numThreads)
+{
+	// without zlib there is only the single threaded stb encoder
+	int rc = stbi_write_png(filename.c_str(), width, height, 3, rgb, width * 3);
+	if(!rc) {
+		return 0;
+	}
+	ifstream file(filename, ios::binary | ios::ate);
+	return static_cast<size_t>(file.tellg());
+}
+
+#endif
+
+bool RowStreamWriter::canStream(ImageFormat format)
+{
+#ifdef HAVE_ZLIB
+	if(format == FORMAT_PNG) {
+		return true;
+	}
+#endif
+	return format == FORMAT_PPM;
+}
+
+RowStreamWriter::RowStreamWriter(const string &filename, int width, int height, int numThreads) :
+	m_file(filename, ios::binary),
+	m_format(formatFromFileName(filename)),
+	m_width(width),
+	m_height(height),
+	m_numThreads(numThreads),
+	m_rowsWritten(0),
+	m_bytes(0),
+	m_adler(0)
+{
+	vector<unsigned char> header;
+	if(m_format == FORMAT_PPM) {
+		string text = "P6\n" + to_string(width) + " " + to_string(height) + "\n255\n";
+		header.assign(text.begin(), text.end());
+	}
+#ifdef HAVE_ZLIB
+	else if(m_format == FORMAT_PNG) {
+		putPngHeader(header, width, height);
+		m_adler = adler32(0, nullptr, 0);
+	}
+#endif
+	m_file.write(reinterpret_cast<const char *>(header.data()), header.size());
+	m_bytes += header.size();
+}
+
+RowStreamWriter::~RowStreamWriter()
+{
+}
+
+bool RowStreamWriter::writeRows(const unsigned char *rgb, int count)
+{
+	size_t rowBytes = size_t(m_width) * 3;
+	if(!isOpen() || count <= 0 || m_rowsWritten + count > m_height) {
+		return false;
+	}
+#ifdef HAVE_ZLIB
+	if(m_format == FORMAT_PNG) {
+		PngStrips strips;
+		bool last = m_rowsWritten + count == m_height;
+		const unsigned char *above = m_rowsWritten > 0 ? m_lastRow.data() : nullptr;
+		if(!deflateStrips(rgb, above, m_width, count, last, m_numThreads, strips)) {
+			return false;
+		}
+		for(size_t s = 0; s < strips.data.size(); s++) {
+			m_adler = adler32_combine(m_adler, strips.adlers[s], static_cast<z_off_t>(strips.filteredSizes[s]));
+			putChunk(m_file, "IDAT", strips.data[s].data(), strips.data[s].size());
+			m_bytes += strips.data[s].size() + 12;
+		}
+		m_lastRow.assign(rgb + (count - 1) * rowBytes, rgb + count * rowBytes);
+		m_rowsWritten += count;
+		return isOpen();
+	}
+#endif
+	m_file.write(reinterpret_cast<const char *>(rgb), count * rowBytes);
+	m_bytes += count * rowBytes;
+	m_rowsWritten += count;
+	return isOpen();
+}
+
+size_t RowStreamWriter::finish()
+{
+	if(!isOpen() || m_rowsWritten != m_height) {
+		return 0;
+	}
+#ifdef HAVE_ZLIB
+	if(m_format == FORMAT_PNG) {
+		vector<unsigned char> trailer;
+		putPngTrailer(trailer, m_adler);
+		m_file.write(reinterpret_cast<const char *>(trailer.data()), trailer.size());
+		m_bytes += trailer.size();
+	}
+#endif
+	m_file.close();
+	return m_file ? m_bytes : 0;
+}
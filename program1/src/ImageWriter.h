@@ -0,0 +1,69 @@
+#ifndef IMAGE_WRITER_H
+#define IMAGE_WRITER_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+/* Output encoders, picked from the file extension */
+enum ImageFormat
+{
+    FORMAT_PNG, // .png, rows compressed in parallel strips when zlib is available
+    FORMAT_PPM, // .ppm, raw binary P6
+    FORMAT_QOI, // .qoi, the "Quite OK Image" format
+    FORMAT_PFM  // .pfm, single channel float
+};
+
+ImageFormat formatFromFileName(const std::string &filename);
+const char *getFormatName(ImageFormat format);
+
+/*
+    Encode 8-bit RGB pixels stored top row first. Each returns the number of
+    bytes written, or 0 when the file could not be written.
+*/
+size_t writePNG(const std::string &filename, const unsigned char *rgb, int width, int height, int numThreads);
+size_t writePPM(const std::string &filename, const unsigned char *rgb, int width, int height);
+size_t writeQOI(const std::string &filename, const unsigned char *rgb, int width, int height);
+
+/*
+    Write one float per pixel as a grayscale PFM. PFM stores the bottom row
+    first, so values is expected bottom row first as well.
+*/
+size_t writePFM(const std::string &filename, const float *values, int width, int height);
+
+/*
+    Writes an image a few rows at a time, top row first, so the whole image
+    never has to be in memory. PNG (only with zlib) and PPM can be streamed.
+    Every writeRows call compresses its rows in parallel strips like writePNG.
+*/
+class RowStreamWriter
+{
+public:
+    static bool canStream(ImageFormat format);
+
+    RowStreamWriter(const std::string &filename, int width, int height, int numThreads);
+    ~RowStreamWriter();
+
+    bool isOpen() const { return m_file.is_open() && m_file.good(); }
+    // count rows of packed rgb, continuing below the rows written before
+    bool writeRows(const unsigned char *rgb, int count);
+    // end the file once every row is written; returns its size in bytes, or 0 on failure
+    size_t finish();
+
+private:
+    RowStreamWriter(const RowStreamWriter &);
+    RowStreamWriter &operator=(const RowStreamWriter &);
+
+    std::ofstream m_file;
+    ImageFormat m_format;
+    int m_width, m_height;
+    int m_numThreads;
+    int m_rowsWritten;
+    size_t m_bytes;
+    // PNG only: the last row written, which the next row is filtered against,
+    // and the Adler-32 of all filtered rows so far
+    std::vector<unsigned char> m_lastRow;
+    unsigned long m_adler;
+};
+
+#endif
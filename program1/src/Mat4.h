@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cmath>
+
+#include "Vec3.h"
+#include "util.h"
+
+/* 4x4 row-major matrix, transforms column vectors (x, y, z, 1) */
+class Mat4
+{
+public:
+    Mat4()
+    {
+        for (int r = 0; r < 4; r++)
+            for (int c = 0; c < 4; c++)
+                m[r][c] = r == c ? 1.0f : 0.0f;
+    }
+
+    float m[4][4];
+
+    Mat4 operator*(const Mat4 &o) const
+    {
+        Mat4 result;
+        for (int r = 0; r < 4; r++)
+            for (int c = 0; c < 4; c++)
+                result.m[r][c] = m[r][0] * o.m[0][c] + m[r][1] * o.m[1][c] + m[r][2] * o.m[2][c] + m[r][3] * o.m[3][c];
+        return result;
+    }
+
+    static Mat4 translate(float x, float y, float z)
+    {
+        Mat4 result;
+        result.m[0][3] = x;
+        result.m[1][3] = y;
+        result.m[2][3] = z;
+        return result;
+    }
+
+    static Mat4 scale(float x, float y, float z)
+    {
+        Mat4 result;
+        result.m[0][0] = x;
+        result.m[1][1] = y;
+        result.m[2][2] = z;
+        return result;
+    }
+
+    // rotation about the y axis by radians
+    static Mat4 rotateY(float angle)
+    {
+        Mat4 result;
+        result.m[0][0] = std::cos(angle);
+        result.m[0][2] = std::sin(angle);
+        result.m[2][0] = -std::sin(angle);
+        result.m[2][2] = std::cos(angle);
+        return result;
+    }
+
+    // OpenGL style perspective projection, fovy in degrees
+    static Mat4 perspective(float fovy, float aspect, float zNear, float zFar)
+    {
+        float f = 1.0f / std::tan(static_cast<float>(degToRad(fovy)) * 0.5f);
+        Mat4 result;
+        result.m[0][0] = f / aspect;
+        result.m[1][1] = f;
+        result.m[2][2] = (zFar + zNear) / (zNear - zFar);
+        result.m[2][3] = 2.0f * zFar * zNear / (zNear - zFar);
+        result.m[3][2] = -1.0f;
+        result.m[3][3] = 0.0f;
+        return result;
+    }
+
+    // OpenGL style view matrix looking from eye towards target
+    static Mat4 lookAt(const Vec3 &eye, const Vec3 &target, const Vec3 &up)
+    {
+        Vec3 f = normalize(Vec3(target.getX() - eye.getX(), target.getY() - eye.getY(), target.getZ() - eye.getZ()));
+        Vec3 s = normalize(cross(f, up));
+        Vec3 u = cross(s, f);
+        Mat4 result;
+        result.m[0][0] = s.getX();
+        result.m[0][1] = s.getY();
+        result.m[0][2] = s.getZ();
+        result.m[1][0] = u.getX();
+        result.m[1][1] = u.getY();
+        result.m[1][2] = u.getZ();
+        result.m[2][0] = -f.getX();
+        result.m[2][1] = -f.getY();
+        result.m[2][2] = -f.getZ();
+        result.m[0][3] = -dot(s, eye);
+        result.m[1][3] = -dot(u, eye);
+        result.m[2][3] = dot(f, eye);
+        return result;
+    }
+
+private:
+    static float dot(const Vec3 &a, const Vec3 &b)
+    {
+        return a.getX() * b.getX() + a.getY() * b.getY() + a.getZ() * b.getZ();
+    }
+
+    static Vec3 cross(const Vec3 &a, const Vec3 &b)
+    {
+        return Vec3(a.getY() * b.getZ() - a.getZ() * b.getY(),
+                    a.getZ() * b.getX() - a.getX() * b.getZ(),
+                    a.getX() * b.getY() - a.getY() * b.getX());
+    }
+
+    static Vec3 normalize(const Vec3 &v)
+    {
+        float length = std::sqrt(dot(v, v));
+        return Vec3(v.getX() / length, v.getY() / length, v.getZ() / length);
+    }
+};
@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <limits>
+#include "MeshBounds.h"
+#include "Tiles.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_AVX_BOUNDS_KERNEL
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// vertices per work item handed to a thread
+static const size_t CHUNK_SIZE = 1 << 16;
+
+// A run of vertices [begin, end) of one shape
+typedef struct
+{
+	size_t shape;
+	size_t begin, end;
+} VertexChunk;
+
+static vector<VertexChunk> makeChunks(const vector<tinyobj::shape_t> &shapes)
+{
+	vector<VertexChunk> chunks;
+	for(size_t i = 0; i < shapes.size(); i++) {
+		size_t count = shapes[i].mesh.positions.size() / 3;
+		for(size_t begin = 0; begin < count; begin += CHUNK_SIZE) {
+			VertexChunk chunk = {i, begin, min(begin + CHUNK_SIZE, count)};
+			chunks.push_back(chunk);
+		}
+	}
+	return chunks;
+}
+
+static void boundsScalar(const float *p, size_t count, float lo[3], float hi[3])
+{
+	for(size_t i = 0; i < 3 * count; i += 3) {
+		for(int c = 0; c < 3; c++) {
+			lo[c] = min(lo[c], p[i + c]);
+			hi[c] = max(hi[c], p[i + c]);
+		}
+	}
+}
+
+static void normalizeScalar(float *p, size_t count, const MeshNormalization &norm)
+{
+	for(size_t i = 0; i < 3 * count; i += 3) {
+		for(int c = 0; c < 3; c++) {
+			p[i + c] = (p[i + c] - norm.shift[c]) * norm.scale;
+		}
+	}
+}
+
+#ifdef HAVE_AVX_BOUNDS_KERNEL
+
+// 8 interleaved vertices are 24 floats, three registers whose lanes repeat
+// x y z, so register k lane j always holds component (8k + j) % 3
+
+__attribute__((target("avx")))
+static void boundsAVX(const float *p, size_t count, float lo[3], float hi[3])
+{
+	__m256 vmin[3], vmax[3];
+	for(int k = 0; k < 3; k++) {
+		vmin[k] = _mm256_set1_ps(numeric_limits<float>::infinity());
+		vmax[k] = _mm256_set1_ps(-numeric_limits<float>::infinity());
+	}
+	size_t v = 0;
+	for(; v + 8 <= count; v += 8) {
+		for(int k = 0; k < 3; k++) {
+			__m256 r = _mm256_loadu_ps(p + 3 * v + 8 * k);
+			vmin[k] = _mm256_min_ps(vmin[k], r);
+			vmax[k] = _mm256_max_ps(vmax[k], r);
+		}
+	}
+
+	float lanesMin[8], lanesMax[8];
+	for(int k = 0; k < 3; k++) {
+		_mm256_storeu_ps(lanesMin, vmin[k]);
+		_mm256_storeu_ps(lanesMax, vmax[k]);
+		for(int j = 0; j < 8; j++) {
+			int c = (8 * k + j) % 3;
+			lo[c] = min(lo[c], lanesMin[j]);
+			hi[c] = max(hi[c], lanesMax[j]);
+		}
+	}
+	boundsScalar(p + 3 * v, count - v, lo, hi);
+}
+
+// No FMA, so the results match the scalar kernel
+__attribute__((target("avx")))
+static void normalizeAVX(float *p, size_t count, const MeshNormalization &norm)
+{
+	__m256 shift[3];
+	for(int k = 0; k < 3; k++) {
+		float lanes[8];
+		for(int j = 0; j < 8; j++) {
+			lanes[j] = norm.shift[(8 * k + j) % 3];
+		}
+		shift[k] = _mm256_loadu_ps(lanes);
+	}
+	__m256 scale = _mm256_set1_ps(norm.scale);
+	size_t v = 0;
+	for(; v + 8 <= count; v += 8) {
+		for(int k = 0; k < 3; k++) {
+			float *r = p + 3 * v + 8 * k;
+			_mm256_storeu_ps(r, _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(r), shift[k]), scale));
+		}
+	}
+	normalizeScalar(p + 3 * v, count - v, norm);
+}
+
+static bool useAVX(bool forceScalar)
+{
+	return !forceScalar && __builtin_cpu_supports("avx");
+}
+
+#else
+
+static bool useAVX(bool forceScalar)
+{
+	return false;
+}
+
+#endif
+
+MeshNormalization computeNormalization(const vector<tinyobj::shape_t> &shapes, int numThreads, bool forceScalar)
+{
+	vector<VertexChunk> chunks = makeChunks(shapes);
+	// each chunk reduces into its own slot, min then max
+	vector<float> bounds(6 * chunks.size());
+	bool avx = useAVX(forceScalar);
+	parallelFor(static_cast<int>(chunks.size()), numThreads, [&](int i) {
+		const VertexChunk &chunk = chunks[i];
+		const float *p = &shapes[chunk.shape].mesh.positions[3 * chunk.begin];
+		float *lo = &bounds[6 * i], *hi = lo + 3;
+		for(int c = 0; c < 3; c++) {
+			lo[c] = numeric_limits<float>::infinity();
+			hi[c] = -numeric_limits<float>::infinity();
+		}
+#ifdef HAVE_AVX_BOUNDS_KERNEL
+		if(avx) {
+			boundsAVX(p, chunk.end - chunk.begin, lo, hi);
+			return;
+		}
+#endif
+		boundsScalar(p, chunk.end - chunk.begin, lo, hi);
+	});
+
+	float lo[3], hi[3];
+	for(int c = 0; c < 3; c++) {
+		lo[c] = 1.1754E+38F;
+		hi[c] = -1.1754E+38F;
+	}
+	for(size_t i = 0; i < chunks.size(); i++) {
+		for(int c = 0; c < 3; c++) {
+			lo[c] = min(lo[c], bounds[6 * i + c]);
+			hi[c] = max(hi[c], bounds[6 * i + 3 + c]);
+		}
+	}
+
+	// the longest axis spans [-1, 1], every axis is centered
+	float extent[3] = {hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2]};
+	float maxExtent = max(extent[0], max(extent[1], extent[2]));
+	MeshNormalization norm;
+	norm.scale = static_cast<float>(2.0 / maxExtent);
+	for(int c = 0; c < 3; c++) {
+		norm.shift[c] = static_cast<float>(lo[c] + extent[c] / 2.0);
+	}
+	return norm;
+}
+
+void applyNormalization(vector<tinyobj::shape_t> &shapes, const MeshNormalization &norm, int numThreads,
+                        bool forceScalar)
+{
+	vector<VertexChunk> chunks = makeChunks(shapes);
+	bool avx = useAVX(forceScalar);
+	parallelFor(static_cast<int>(chunks.size()), numThreads, [&](int i) {
+		const VertexChunk &chunk = chunks[i];
+		float *p = &shapes[chunk.shape].mesh.positions[3 * chunk.begin];
+#ifdef HAVE_AVX_BOUNDS_KERNEL
+		if(avx) {
+			normalizeAVX(p, chunk.end - chunk.begin, norm);
+			return;
+		}
+#endif
+		normalizeScalar(p, chunk.end - chunk.begin, norm);
+	});
+}
@@ -0,0 +1,37 @@
+#ifndef MESH_BOUNDS_H
+#define MESH_BOUNDS_H
+
+#include <vector>
+#include "Mat4.h"
+#include "tiny_obj_loader.h"
+
+/*
+    The uniform scale and shift that fit a mesh into [-1, 1] on its longest
+    axis and center it: p' = (p - shift) * scale
+*/
+typedef struct
+{
+    float shift[3];
+    float scale;
+} MeshNormalization;
+
+/*
+    Find the bounds of every position of every shape and the normalization
+    they give. The positions are split into chunks reduced on numThreads
+    threads, 8 vertices at a time with AVX when the CPU supports it.
+*/
+MeshNormalization computeNormalization(const std::vector<tinyobj::shape_t> &shapes, int numThreads,
+                                       bool forceScalar);
+
+/* Rewrite every position in place, chunked and vectorized the same way */
+void applyNormalization(std::vector<tinyobj::shape_t> &shapes, const MeshNormalization &norm, int numThreads,
+                        bool forceScalar);
+
+/* The normalization as a matrix, to apply it in the vertex stage instead */
+inline Mat4 normalizationMatrix(const MeshNormalization &norm)
+{
+    return Mat4::scale(norm.scale, norm.scale, norm.scale) *
+           Mat4::translate(-norm.shift[0], -norm.shift[1], -norm.shift[2]);
+}
+
+#endif
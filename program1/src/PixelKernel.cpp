@@ -0,0 +1,150 @@
+#include "PixelKernel.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_AVX2_KERNEL
+#include <immintrin.h>
+#endif
+
+// z is mapped from [zMin, zMax] to the rgb values below
+static const float zMin = -1.0f, zMax = 1.0f;
+static const float zRange = zMax - zMin;
+
+void shadeDepth(float z, unsigned char *rgb)
+{
+	float t = (z - zMin) / zRange;
+	rgb[0] = static_cast<unsigned char>(static_cast<int>(t * 100.0f));
+	rgb[1] = static_cast<unsigned char>(static_cast<int>(t * 200.0f));
+	rgb[2] = static_cast<unsigned char>(static_cast<int>(t * 200.0f));
+}
+
+unsigned int shadeRowScalar(const RowSetup &s, float w0, float w1, float w2, int count,
+                            float *zRow, unsigned char *rgb)
+{
+	unsigned int mask = 0;
+	for(int i = 0; i < count; i++) {
+		float lane = static_cast<float>(i);
+		float e0 = w0 + lane * s.a0;
+		float e1 = w1 + lane * s.a1;
+		float e2 = w2 + lane * s.a2;
+		// top-left fill rule: pixels exactly on an edge only count for top and left edges
+		if((e0 > 0 || (e0 == 0 && s.topLeft0)) &&
+		   (e1 > 0 || (e1 == 0 && s.topLeft1)) &&
+		   (e2 > 0 || (e2 == 0 && s.topLeft2))) {
+			float z = s.z0 + e1 * s.dz1 + e2 * s.dz2;
+			if(z > zRow[i]) {
+				zRow[i] = z;
+				if(rgb) {
+					shadeDepth(z, rgb + 3*i);
+				}
+				mask |= 1u << i;
+			}
+		}
+	}
+	return mask;
+}
+
+unsigned int shadeRowFixed(const FixedRowSetup &s, int64_t w0, int64_t w1, int64_t w2, int count,
+                           float *zRow, unsigned char *rgb)
+{
+	unsigned int mask = 0;
+	for(int i = 0; i < count; i++) {
+		// a pixel is inside when none of the edge values has its sign bit set
+		if((w0 | w1 | w2) >= 0) {
+			float z = s.z0 + static_cast<float>(w1 - s.bias1) * s.dz1 + static_cast<float>(w2 - s.bias2) * s.dz2;
+			if(z > zRow[i]) {
+				zRow[i] = z;
+				if(rgb) {
+					shadeDepth(z, rgb + 3*i);
+				}
+				mask |= 1u << i;
+			}
+		}
+		w0 += s.a0;
+		w1 += s.a1;
+		w2 += s.a2;
+	}
+	return mask;
+}
+
+#ifdef HAVE_AVX2_KERNEL
+
+__attribute__((target("avx2")))
+static inline __m256 insideEdge(__m256 e, bool topLeft)
+{
+	const __m256 zero = _mm256_setzero_ps();
+	__m256 inside = _mm256_cmp_ps(e, zero, _CMP_GT_OQ);
+	if(topLeft) {
+		inside = _mm256_or_ps(inside, _mm256_cmp_ps(e, zero, _CMP_EQ_OQ));
+	}
+	return inside;
+}
+
+// No FMA in the target list so lane * a + w rounds exactly like the scalar kernel
+__attribute__((target("avx2")))
+static unsigned int shadeRowAVX2(const RowSetup &s, float w0, float w1, float w2, int count,
+                                 float *zRow, unsigned char *rgb)
+{
+	const __m256 lane = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+	const __m256i laneIdx = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+	__m256 e0 = _mm256_add_ps(_mm256_set1_ps(w0), _mm256_mul_ps(lane, _mm256_set1_ps(s.a0)));
+	__m256 e1 = _mm256_add_ps(_mm256_set1_ps(w1), _mm256_mul_ps(lane, _mm256_set1_ps(s.a1)));
+	__m256 e2 = _mm256_add_ps(_mm256_set1_ps(w2), _mm256_mul_ps(lane, _mm256_set1_ps(s.a2)));
+
+	__m256 covered = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(count), laneIdx));
+	covered = _mm256_and_ps(covered, insideEdge(e0, s.topLeft0));
+	covered = _mm256_and_ps(covered, insideEdge(e1, s.topLeft1));
+	covered = _mm256_and_ps(covered, insideEdge(e2, s.topLeft2));
+	if(_mm256_movemask_ps(covered) == 0) {
+		return 0;
+	}
+
+	// masked load and store never touch pixels past the end of the row
+	__m256 z = _mm256_add_ps(_mm256_set1_ps(s.z0), _mm256_mul_ps(e1, _mm256_set1_ps(s.dz1)));
+	z = _mm256_add_ps(z, _mm256_mul_ps(e2, _mm256_set1_ps(s.dz2)));
+	__m256 zOld = _mm256_maskload_ps(zRow, _mm256_castps_si256(covered));
+	__m256 pass = _mm256_and_ps(covered, _mm256_cmp_ps(z, zOld, _CMP_GT_OQ));
+	unsigned int mask = static_cast<unsigned int>(_mm256_movemask_ps(pass));
+	if(mask == 0) {
+		return 0;
+	}
+	_mm256_maskstore_ps(zRow, _mm256_castps_si256(pass), z);
+	if(!rgb) {
+		return mask;
+	}
+
+	__m256 t = _mm256_div_ps(_mm256_sub_ps(z, _mm256_set1_ps(zMin)), _mm256_set1_ps(zRange));
+	__m256i red = _mm256_cvttps_epi32(_mm256_mul_ps(t, _mm256_set1_ps(100.0f)));
+	__m256i green = _mm256_cvttps_epi32(_mm256_mul_ps(t, _mm256_set1_ps(200.0f)));
+	alignas(32) int r[KERNEL_WIDTH], g[KERNEL_WIDTH];
+	_mm256_store_si256(reinterpret_cast<__m256i *>(r), red);
+	_mm256_store_si256(reinterpret_cast<__m256i *>(g), green);
+	for(int i = 0; i < KERNEL_WIDTH; i++) {
+		rgb[3*i + 0] = static_cast<unsigned char>(r[i]);
+		rgb[3*i + 1] = static_cast<unsigned char>(g[i]);
+		rgb[3*i + 2] = static_cast<unsigned char>(g[i]);
+	}
+	return mask;
+}
+
+#endif
+
+ShadeRowFn selectShadeRow(bool forceScalar)
+{
+#ifdef HAVE_AVX2_KERNEL
+	if(!forceScalar && __builtin_cpu_supports("avx2")) {
+		return shadeRowAVX2;
+	}
+#endif
+	return shadeRowScalar;
+}
+
+const char *getShadeRowName(ShadeRowFn fn)
+{
+#ifdef HAVE_AVX2_KERNEL
+	if(fn == shadeRowAVX2) {
+		return "avx2";
+	}
+#endif
+	return "scalar";
+}
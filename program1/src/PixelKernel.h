@@ -0,0 +1,61 @@
+#ifndef PIXEL_KERNEL_H
+#define PIXEL_KERNEL_H
+
+#include <cstdint>
+
+/* Number of horizontally adjacent pixels a kernel call handles */
+const int KERNEL_WIDTH = 8;
+
+/*
+    Per-triangle constants the pixel kernel needs. The edge values of lane i
+    are w + i * a, so every kernel variant produces exactly the same floats.
+*/
+typedef struct
+{
+    float a0, a1, a2;
+    bool topLeft0, topLeft1, topLeft2;
+    float z0, dz1, dz2;
+} RowSetup;
+
+/*
+    Coverage test, depth test and depth-to-color shading for up to
+    KERNEL_WIDTH pixels of one row. w0, w1 and w2 are the edge values of the
+    first pixel and count is the number of valid pixels. zRow points at the
+    z-buffer entry of the first pixel and is updated in place. The packed RGB
+    of every pixel that passed is written to rgb, and the returned bit mask
+    has bit i set when pixel i passed. With rgb null only depth is written,
+    for the visibility buffer, which shades later.
+*/
+typedef unsigned int (*ShadeRowFn)(const RowSetup &setup, float w0, float w1, float w2, int count,
+                                   float *zRow, unsigned char *rgb);
+
+unsigned int shadeRowScalar(const RowSetup &setup, float w0, float w1, float w2, int count,
+                            float *zRow, unsigned char *rgb);
+
+/*
+    Per-triangle constants of the fixed-point kernel. Edge values are 64-bit
+    integers with the fill rule bias already added, so a pixel is covered when
+    all three are >= 0. a0, a1 and a2 are the steps from one pixel to the next.
+*/
+typedef struct
+{
+    int64_t a0, a1, a2;
+    int64_t bias1, bias2;
+    float z0, dz1, dz2;
+} FixedRowSetup;
+
+/* Same contract as ShadeRowFn for the fixed-point edge values */
+unsigned int shadeRowFixed(const FixedRowSetup &setup, int64_t w0, int64_t w1, int64_t w2, int count,
+                           float *zRow, unsigned char *rgb);
+
+/* The depth-to-color mapping every kernel shades with */
+void shadeDepth(float z, unsigned char *rgb);
+
+/*
+    Pick the fastest kernel the CPU supports, or the scalar one if forceScalar
+    is set. All kernels produce identical images.
+*/
+ShadeRowFn selectShadeRow(bool forceScalar);
+const char *getShadeRowName(ShadeRowFn fn);
+
+#endif
@@ -0,0 +1,202 @@
+#ifndef RASTER_SETUP_H
+#define RASTER_SETUP_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include "Triangle.h"
+#include "PixelKernel.h"
+
+/* Bits of subpixel precision of the fixed-point rasterizer */
+const int SUBPIXEL_BITS = 8;
+const int SUBPIXEL_ONE = 1 << SUBPIXEL_BITS;
+
+/*
+    Per-triangle state the block walker in main.cpp needs from a rasterizer:
+    the pixel bounds of the triangle, the edge values at a block corner, how
+    far each edge can grow across a block, and how to step and shade a row.
+    FloatRaster works on the float edges of Triangle, FixedRaster snaps the
+    vertices to a subpixel grid and uses exact integer edge functions.
+*/
+class FloatRaster
+{
+public:
+    typedef float Value;
+
+    FloatRaster(const Triangle &triangle, ShadeRowFn shadeRow, int blockSize) : m_shadeRow(shadeRow)
+    {
+        m_valid = triangle.getArea() > 0;
+        if (!m_valid)
+            return;
+
+        BBox bbox = triangle.getBBox();
+        m_minX = static_cast<int>(bbox.minX);
+        m_minY = static_cast<int>(bbox.minY);
+        m_maxX = static_cast<int>(std::floor(bbox.maxX));
+        m_maxY = static_cast<int>(std::floor(bbox.maxY));
+
+        for (int i = 0; i < 3; i++)
+        {
+            m_edges[i] = triangle.getEdge(i);
+            // offset from a block's corner to the corner where the edge is largest
+            m_reach[i] = (std::max(m_edges[i].a, 0.0f) + std::max(m_edges[i].b, 0.0f)) * (blockSize - 1);
+        }
+
+        m_setup.a0 = m_edges[0].a;
+        m_setup.a1 = m_edges[1].a;
+        m_setup.a2 = m_edges[2].a;
+        m_setup.topLeft0 = m_edges[0].topLeft;
+        m_setup.topLeft1 = m_edges[1].topLeft;
+        m_setup.topLeft2 = m_edges[2].topLeft;
+        // depth is interpolated from the two barycentric weights beta and gamma
+        m_setup.z0 = triangle.getZ0();
+        m_setup.dz1 = (triangle.getZ1() - m_setup.z0) / triangle.getArea();
+        m_setup.dz2 = (triangle.getZ2() - m_setup.z0) / triangle.getArea();
+    }
+
+    bool isValid() const { return m_valid; }
+    int getMinX() const { return m_minX; }
+    int getMinY() const { return m_minY; }
+    int getMaxX() const { return m_maxX; }
+    int getMaxY() const { return m_maxY; }
+
+    // edge values at pixel (x, y); returns false when the block starting there is outside an edge
+    bool blockCorner(int x, int y, Value w[3]) const
+    {
+        for (int i = 0; i < 3; i++)
+            w[i] = m_edges[i].a * (x - m_edges[i].x0) + m_edges[i].b * (y - m_edges[i].y0);
+        return w[0] + m_reach[0] >= 0 && w[1] + m_reach[1] >= 0 && w[2] + m_reach[2] >= 0;
+    }
+
+    void offset(Value w[3], int dx, int dy) const
+    {
+        for (int i = 0; i < 3; i++)
+            w[i] += m_edges[i].a * dx + m_edges[i].b * dy;
+    }
+
+    void stepRow(Value w[3]) const
+    {
+        for (int i = 0; i < 3; i++)
+            w[i] += m_edges[i].b;
+    }
+
+    unsigned int shadeRow(const Value w[3], int count, float *zRow, unsigned char *rgb) const
+    {
+        return m_shadeRow(m_setup, w[0], w[1], w[2], count, zRow, rgb);
+    }
+
+private:
+    ShadeRowFn m_shadeRow;
+    bool m_valid;
+    int m_minX, m_minY, m_maxX, m_maxY;
+    Edge m_edges[3];
+    float m_reach[3];
+    RowSetup m_setup;
+};
+
+/*
+    Vertices are snapped to 1 / SUBPIXEL_ONE of a pixel and the edge functions
+    E(X, Y) = a * X + b * Y + c are evaluated exactly in 64-bit integers. The
+    top-left rule is applied by biasing c of the other edges by -1, so two
+    triangles sharing an edge never both cover a pixel on it and never leave a
+    gap. The result does not depend on floating point contraction.
+*/
+class FixedRaster
+{
+public:
+    typedef int64_t Value;
+
+    FixedRaster(const Triangle &triangle, int blockSize)
+    {
+        int64_t xs[3], ys[3];
+        const Vec3 verts[3] = {triangle.getV0(), triangle.getV1(), triangle.getV2()};
+        for (int i = 0; i < 3; i++)
+        {
+            xs[i] = std::llround(verts[i].getX() * SUBPIXEL_ONE);
+            ys[i] = std::llround(verts[i].getY() * SUBPIXEL_ONE);
+        }
+
+        int64_t area = (xs[1] - xs[0]) * (ys[2] - ys[0]) - (xs[2] - xs[0]) * (ys[1] - ys[0]);
+        m_valid = area != 0;
+        if (!m_valid)
+            return;
+        int64_t sign = area > 0 ? 1 : -1;
+        area *= sign;
+
+        // pixel (x, y) samples the subpixel position (x << SUBPIXEL_BITS, y << SUBPIXEL_BITS)
+        int64_t minX = std::min(xs[0], std::min(xs[1], xs[2]));
+        int64_t minY = std::min(ys[0], std::min(ys[1], ys[2]));
+        int64_t maxX = std::max(xs[0], std::max(xs[1], xs[2]));
+        int64_t maxY = std::max(ys[0], std::max(ys[1], ys[2]));
+        m_minX = static_cast<int>((minX + SUBPIXEL_ONE - 1) >> SUBPIXEL_BITS);
+        m_minY = static_cast<int>((minY + SUBPIXEL_ONE - 1) >> SUBPIXEL_BITS);
+        m_maxX = static_cast<int>(maxX >> SUBPIXEL_BITS);
+        m_maxY = static_cast<int>(maxY >> SUBPIXEL_BITS);
+
+        // edge i runs between the two vertices other than vertex i
+        for (int i = 0; i < 3; i++)
+        {
+            int from = (i + 1) % 3, to = (i + 2) % 3;
+            int64_t a = sign * (ys[from] - ys[to]);
+            int64_t b = sign * (xs[to] - xs[from]);
+            int64_t c = sign * (xs[from] * ys[to] - xs[to] * ys[from]);
+            bool topLeft = a > 0 || (a == 0 && b < 0);
+            m_bias[i] = topLeft ? 0 : -1;
+            m_a[i] = a;
+            m_b[i] = b;
+            m_c[i] = c + m_bias[i];
+            m_reach[i] = (std::max<int64_t>(a, 0) + std::max<int64_t>(b, 0)) * (blockSize - 1) * SUBPIXEL_ONE;
+        }
+
+        m_setup.a0 = m_a[0] * SUBPIXEL_ONE;
+        m_setup.a1 = m_a[1] * SUBPIXEL_ONE;
+        m_setup.a2 = m_a[2] * SUBPIXEL_ONE;
+        m_setup.bias1 = m_bias[1];
+        m_setup.bias2 = m_bias[2];
+        m_setup.z0 = triangle.getZ0();
+        m_setup.dz1 = (triangle.getZ1() - m_setup.z0) / static_cast<float>(area);
+        m_setup.dz2 = (triangle.getZ2() - m_setup.z0) / static_cast<float>(area);
+    }
+
+    bool isValid() const { return m_valid; }
+    int getMinX() const { return m_minX; }
+    int getMinY() const { return m_minY; }
+    int getMaxX() const { return m_maxX; }
+    int getMaxY() const { return m_maxY; }
+
+    bool blockCorner(int x, int y, Value w[3]) const
+    {
+        int64_t sx = static_cast<int64_t>(x) << SUBPIXEL_BITS;
+        int64_t sy = static_cast<int64_t>(y) << SUBPIXEL_BITS;
+        for (int i = 0; i < 3; i++)
+            w[i] = m_a[i] * sx + m_b[i] * sy + m_c[i];
+        return w[0] + m_reach[0] >= 0 && w[1] + m_reach[1] >= 0 && w[2] + m_reach[2] >= 0;
+    }
+
+    void offset(Value w[3], int dx, int dy) const
+    {
+        for (int i = 0; i < 3; i++)
+            w[i] += (m_a[i] * dx + m_b[i] * dy) * SUBPIXEL_ONE;
+    }
+
+    void stepRow(Value w[3]) const
+    {
+        for (int i = 0; i < 3; i++)
+            w[i] += m_b[i] * SUBPIXEL_ONE;
+    }
+
+    unsigned int shadeRow(const Value w[3], int count, float *zRow, unsigned char *rgb) const
+    {
+        return shadeRowFixed(m_setup, w[0], w[1], w[2], count, zRow, rgb);
+    }
+
+private:
+    bool m_valid;
+    int m_minX, m_minY, m_maxX, m_maxY;
+    int64_t m_a[3], m_b[3], m_c[3];
+    int64_t m_bias[3];
+    int64_t m_reach[3];
+    FixedRowSetup m_setup;
+};
+
+#endif
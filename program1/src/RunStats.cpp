@@ -0,0 +1,118 @@
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include "RunStats.h"
+
+using namespace std;
+
+// add value to the entry called name, appending it when it is new
+static void accumulate(vector<pair<string, double>> &entries, const string &name, double value)
+{
+	for(auto &entry : entries) {
+		if(entry.first == name) {
+			entry.second += value;
+			return;
+		}
+	}
+	entries.push_back(make_pair(name, value));
+}
+
+static string quote(const string &s)
+{
+	string out = "\"";
+	for(char c : s) {
+		if(c == '"' || c == '\\') {
+			out += '\\';
+			out += c;
+		} else if(static_cast<unsigned char>(c) < 0x20) {
+			char escaped[8];
+			snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+			out += escaped;
+		} else {
+			out += c;
+		}
+	}
+	return out + "\"";
+}
+
+// integers print without a fraction, JSON has no infinity or NaN
+static string number(double value)
+{
+	if(value != value || value - value != 0) {
+		return "null";
+	}
+	ostringstream s;
+	s << setprecision(15) << value;
+	return s.str();
+}
+
+void RunStats::setInfo(const string &name, const string &value)
+{
+	if(!m_enabled) {
+		return;
+	}
+	lock_guard<mutex> lock(m_mutex);
+	m_info.push_back(make_pair(name, quote(value)));
+}
+
+void RunStats::setInfo(const string &name, double value)
+{
+	if(!m_enabled) {
+		return;
+	}
+	lock_guard<mutex> lock(m_mutex);
+	m_info.push_back(make_pair(name, number(value)));
+}
+
+void RunStats::addTime(const string &stage, double seconds)
+{
+	if(!m_enabled) {
+		return;
+	}
+	lock_guard<mutex> lock(m_mutex);
+	accumulate(m_times, stage, seconds);
+}
+
+void RunStats::addCount(const string &name, double value)
+{
+	if(!m_enabled) {
+		return;
+	}
+	lock_guard<mutex> lock(m_mutex);
+	accumulate(m_counts, name, value);
+}
+
+double RunStats::getCount(const string &name) const
+{
+	lock_guard<mutex> lock(m_mutex);
+	for(const auto &entry : m_counts) {
+		if(entry.first == name) {
+			return entry.second;
+		}
+	}
+	return 0.0;
+}
+
+bool RunStats::writeJson(const string &filename) const
+{
+	lock_guard<mutex> lock(m_mutex);
+	ostringstream json;
+	json << "{\n  \"info\": {";
+	for(size_t i = 0; i < m_info.size(); i++) {
+		json << (i ? ",\n" : "\n") << "    " << quote(m_info[i].first) << ": " << m_info[i].second;
+	}
+	json << "\n  },\n  \"stages_ms\": {";
+	for(size_t i = 0; i < m_times.size(); i++) {
+		json << (i ? ",\n" : "\n") << "    " << quote(m_times[i].first) << ": " << number(m_times[i].second * 1000.0);
+	}
+	json << "\n  },\n  \"counters\": {";
+	for(size_t i = 0; i < m_counts.size(); i++) {
+		json << (i ? ",\n" : "\n") << "    " << quote(m_counts[i].first) << ": " << number(m_counts[i].second);
+	}
+	json << "\n  }\n}\n";
+
+	ofstream out(filename.c_str());
+	out << json.str();
+	return static_cast<bool>(out);
+}
@@ -0,0 +1,66 @@
+#ifndef RUN_STATS_H
+#define RUN_STATS_H
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+    Stage timings and counters of one run, written as JSON for --stats.
+    Times and counts with the same name add up, so a stage that runs once
+    per frame or band reports its total. Names keep the order they were
+    first used in. Everything is ignored until enable() is called, and all
+    calls are safe from any thread.
+*/
+class RunStats
+{
+public:
+    RunStats() : m_enabled(false) {}
+
+    void enable() { m_enabled = true; }
+    bool isEnabled() const { return m_enabled; }
+
+    // describe the run: file names, image size and so on
+    void setInfo(const std::string &name, const std::string &value);
+    void setInfo(const std::string &name, double value);
+    void addTime(const std::string &stage, double seconds);
+    void addCount(const std::string &name, double value);
+    double getCount(const std::string &name) const;
+
+    // {"info": {...}, "stages_ms": {...}, "counters": {...}}
+    bool writeJson(const std::string &filename) const;
+
+private:
+    RunStats(const RunStats &);
+    RunStats &operator=(const RunStats &);
+
+    bool m_enabled;
+    mutable std::mutex m_mutex;
+    std::vector<std::pair<std::string, std::string>> m_info;
+    std::vector<std::pair<std::string, double>> m_times;
+    std::vector<std::pair<std::string, double>> m_counts;
+};
+
+/* Adds the time from its construction to its destruction to a stage */
+class ScopedTimer
+{
+public:
+    ScopedTimer(RunStats &stats, const char *stage) :
+        m_stats(stats), m_stage(stage), m_start(std::chrono::steady_clock::now())
+    {
+    }
+    ~ScopedTimer()
+    {
+        if (m_stats.isEnabled())
+            m_stats.addTime(m_stage, std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count());
+    }
+
+private:
+    RunStats &m_stats;
+    const char *m_stage;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+#endif
@@ -0,0 +1,30 @@
+#include "Samples.h"
+
+// Direct3D's standard multisample positions, in 1/16 of a pixel
+static const int POSITIONS_2[2][2] = {{4, 4}, {-4, -4}};
+static const int POSITIONS_4[4][2] = {{-2, -6}, {6, -2}, {-6, 2}, {2, 6}};
+static const int POSITIONS_8[8][2] = {{1, -3}, {-1, 3}, {5, 1}, {-3, -5}, {-5, 5}, {-7, -1}, {3, 7}, {7, -7}};
+
+static SamplePattern makePattern(const int (*positions)[2], int count)
+{
+	SamplePattern pattern;
+	pattern.count = count;
+	for(int i = 0; i < MAX_SAMPLES; i++) {
+		pattern.dx[i] = i < count ? positions[i][0] / 16.0f : 0.0f;
+		pattern.dy[i] = i < count ? positions[i][1] / 16.0f : 0.0f;
+	}
+	return pattern;
+}
+
+const SamplePattern *getSamplePattern(int count)
+{
+	static const SamplePattern pattern2 = makePattern(POSITIONS_2, 2);
+	static const SamplePattern pattern4 = makePattern(POSITIONS_4, 4);
+	static const SamplePattern pattern8 = makePattern(POSITIONS_8, 8);
+	switch(count) {
+		case 2: return &pattern2;
+		case 4: return &pattern4;
+		case 8: return &pattern8;
+		default: return nullptr;
+	}
+}
@@ -0,0 +1,21 @@
+#ifndef SAMPLES_H
+#define SAMPLES_H
+
+/* Most samples per pixel any pattern has */
+const int MAX_SAMPLES = 8;
+
+/*
+    Sample positions inside a pixel, as offsets in pixels from the point the
+    pixel is normally sampled at. Every offset lies in [-0.5, 0.5).
+*/
+typedef struct
+{
+    int count;
+    float dx[MAX_SAMPLES];
+    float dy[MAX_SAMPLES];
+} SamplePattern;
+
+/* The standard rotated grid patterns for 2, 4 and 8 samples, null for any other count */
+const SamplePattern *getSamplePattern(int count);
+
+#endif
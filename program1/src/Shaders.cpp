@@ -0,0 +1,41 @@
+#include "Shaders.h"
+
+ShadeParams makeShadeParams(const Mat4 &mvp)
+{
+	// Depth is -z / w. With a perspective w = -z_eye, so the viewer lies
+	// along minus the w row; an orthographic w row is (0, 0, 0, 1) and then
+	// depth grows towards the viewer along minus the z row.
+	const float *row = mvp.m[3];
+	if(row[0] == 0 && row[1] == 0 && row[2] == 0) {
+		row = mvp.m[2];
+	}
+	ShadeParams p;
+	float right[3], up[3];
+	for(int c = 0; c < 3; c++) {
+		p.view[c] = -row[c];
+		right[c] = mvp.m[0][c];
+		up[c] = mvp.m[1][c];
+	}
+	normalize3(p.view);
+	normalize3(right);
+	normalize3(up);
+
+	// the light sits above and to the left of the viewer
+	for(int c = 0; c < 3; c++) {
+		p.light[c] = p.view[c] + 0.5f * up[c] - 0.5f * right[c];
+	}
+	normalize3(p.light);
+	for(int c = 0; c < 3; c++) {
+		p.half[c] = p.light[c] + p.view[c];
+	}
+	normalize3(p.half);
+
+	p.ambient = 0.15f;
+	p.diffuse = 0.75f;
+	p.specular = 0.35f;
+	p.shininess = 32.0f;
+	p.color[0] = 0.9f;
+	p.color[1] = 0.75f;
+	p.color[2] = 0.55f;
+	return p;
+}
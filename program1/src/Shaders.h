@@ -0,0 +1,123 @@
+#ifndef SHADERS_H
+#define SHADERS_H
+
+#include <algorithm>
+#include <cmath>
+#include "Mat4.h"
+#include "PixelKernel.h"
+
+/* What the <mode> argument selects */
+enum RenderMode
+{
+    MODE_DEPTH = 0,   // filled, colored by depth
+    MODE_LINES = 1,   // triangle edges colored by depth
+    MODE_NORMALS = 2, // filled, the normal as a color
+    MODE_GOURAUD = 3, // filled, Blinn-Phong lit per vertex
+    MODE_PHONG = 4,   // filled, Blinn-Phong lit per pixel
+    MODE_COUNT
+};
+
+/* Does the mode need per-vertex normals */
+inline bool modeUsesNormals(int mode) { return mode >= MODE_NORMALS && mode < MODE_COUNT; }
+
+/*
+    Lighting shared by the lit modes. Lighting is done in object space with
+    a directional light attached to the viewer, so it follows the camera.
+*/
+typedef struct
+{
+    float view[3];  // unit vector towards the viewer
+    float light[3]; // unit vector towards the light
+    float half[3];  // Blinn-Phong half vector
+    float ambient, diffuse, specular, shininess;
+    float color[3];
+} ShadeParams;
+
+/* Light and view directions in object space for a model-view-projection matrix */
+ShadeParams makeShadeParams(const Mat4 &mvp);
+
+inline void normalize3(float v[3])
+{
+    float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    if (length > 0)
+    {
+        v[0] /= length;
+        v[1] /= length;
+        v[2] /= length;
+    }
+}
+
+inline unsigned char toByte(float value)
+{
+    return static_cast<unsigned char>(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+/* Blinn-Phong with the surface color and a white highlight, rgb in [0, 1] */
+inline void blinnPhong(const float normal[3], const ShadeParams &p, float rgb[3])
+{
+    float nDotL = normal[0] * p.light[0] + normal[1] * p.light[1] + normal[2] * p.light[2];
+    float nDotH = normal[0] * p.half[0] + normal[1] * p.half[1] + normal[2] * p.half[2];
+    float diffuse = p.diffuse * std::max(nDotL, 0.0f);
+    float specular = nDotL > 0 ? p.specular * std::pow(std::max(nDotH, 0.0f), p.shininess) : 0.0f;
+    for (int c = 0; c < 3; c++)
+        rgb[c] = p.color[c] * (p.ambient + diffuse) + specular;
+}
+
+/*
+    Shading modes for the filled rasterizer. Each declares how many floats
+    it interpolates across a triangle (NUM_VARYINGS), computes them once per
+    vertex from the vertex normal (vertex) and turns the interpolated values
+    into a color (shade). The rasterizer is instantiated once per shader, so a
+    mode only pays for the varyings it declares.
+*/
+
+/* The original coloring by depth. Without varyings the pixel kernel shades. */
+struct DepthShader
+{
+    enum { NUM_VARYINGS = 0 };
+    static void vertex(const float *, const ShadeParams &, float *) {}
+    static void shade(const float *, float z, const ShadeParams &, unsigned char *rgb) { shadeDepth(z, rgb); }
+};
+
+/* The interpolated normal mapped from [-1, 1] to [0, 255] */
+struct NormalShader
+{
+    enum { NUM_VARYINGS = 3 };
+    static void vertex(const float *normal, const ShadeParams &, float *out) { std::copy(normal, normal + 3, out); }
+    static void shade(const float *varyings, float, const ShadeParams &, unsigned char *rgb)
+    {
+        float n[3] = {varyings[0], varyings[1], varyings[2]};
+        normalize3(n);
+        for (int c = 0; c < 3; c++)
+            rgb[c] = toByte(n[c] * 0.5f + 0.5f);
+    }
+};
+
+/* Lit at the vertices, the colors are interpolated */
+struct GouraudShader
+{
+    enum { NUM_VARYINGS = 3 };
+    static void vertex(const float *normal, const ShadeParams &params, float *out) { blinnPhong(normal, params, out); }
+    static void shade(const float *varyings, float, const ShadeParams &, unsigned char *rgb)
+    {
+        for (int c = 0; c < 3; c++)
+            rgb[c] = toByte(varyings[c]);
+    }
+};
+
+/* The normal is interpolated and lit at every pixel */
+struct PhongShader
+{
+    enum { NUM_VARYINGS = 3 };
+    static void vertex(const float *normal, const ShadeParams &, float *out) { std::copy(normal, normal + 3, out); }
+    static void shade(const float *varyings, float, const ShadeParams &params, unsigned char *rgb)
+    {
+        float n[3] = {varyings[0], varyings[1], varyings[2]}, color[3];
+        normalize3(n);
+        blinnPhong(n, params, color);
+        for (int c = 0; c < 3; c++)
+            rgb[c] = toByte(color[c]);
+    }
+};
+
+#endif
@@ -0,0 +1,79 @@
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include "Tiles.h"
+
+using namespace std;
+
+TileGrid::TileGrid(int width, int height, int tileSize) :
+	m_width(width),
+	m_height(height),
+	m_tileSize(tileSize),
+	m_tilesX((width + tileSize - 1) / tileSize),
+	m_tilesY((height + tileSize - 1) / tileSize),
+	m_bins(m_tilesX * m_tilesY)
+{
+}
+
+Rect TileGrid::getTileRect(int tile) const
+{
+	Rect rect;
+	rect.minX = (tile % m_tilesX) * m_tileSize;
+	rect.minY = (tile / m_tilesX) * m_tileSize;
+	rect.maxX = min(rect.minX + m_tileSize, m_width) - 1;
+	rect.maxY = min(rect.minY + m_tileSize, m_height) - 1;
+	return rect;
+}
+
+void TileGrid::binTriangle(unsigned int triIndex, const BBox &bbox)
+{
+	// Triangles entirely off screen touch no tile
+	if(bbox.maxX < 0 || bbox.maxY < 0 || bbox.minX >= m_width || bbox.minY >= m_height) {
+		return;
+	}
+
+	int tx0 = max(static_cast<int>(bbox.minX), 0) / m_tileSize;
+	int ty0 = max(static_cast<int>(bbox.minY), 0) / m_tileSize;
+	int tx1 = min(static_cast<int>(bbox.maxX), m_width - 1) / m_tileSize;
+	int ty1 = min(static_cast<int>(bbox.maxY), m_height - 1) / m_tileSize;
+	for(int ty = ty0; ty <= ty1; ty++) {
+		for(int tx = tx0; tx <= tx1; tx++) {
+			m_bins[ty * m_tilesX + tx].push_back(triIndex);
+		}
+	}
+}
+
+void TileGrid::clear()
+{
+	for(auto &bin : m_bins) {
+		bin.clear();
+	}
+}
+
+void parallelFor(int count, int numThreads, const function<void(int)> &body)
+{
+	numThreads = max(1, min(numThreads, count));
+	if(numThreads == 1) {
+		for(int i = 0; i < count; i++) {
+			body(i);
+		}
+		return;
+	}
+
+	atomic<int> next(0);
+	auto worker = [&]() {
+		for(int i = next++; i < count; i = next++) {
+			body(i);
+		}
+	};
+
+	// The calling thread works too instead of idling in join()
+	vector<thread> threads;
+	for(int t = 1; t < numThreads; t++) {
+		threads.emplace_back(worker);
+	}
+	worker();
+	for(auto &t : threads) {
+		t.join();
+	}
+}
@@ -0,0 +1,58 @@
+#ifndef TILES_H
+#define TILES_H
+
+#include <functional>
+#include <vector>
+#include "Triangle.h"
+
+/* Screen tile dimensions in pixels */
+const int TILE_SIZE = 64;
+
+/* Inclusive pixel rectangle */
+typedef struct
+{
+    int minX, minY;
+    int maxX, maxY;
+} Rect;
+
+/*
+    Splits the image into TILE_SIZE x TILE_SIZE tiles and keeps, for every tile,
+    the list of triangles whose bounding box overlaps it. Triangles are appended
+    in submission order so rasterizing a bin front to back gives the same
+    depth test results as drawing the whole triangle list serially.
+*/
+class TileGrid
+{
+public:
+    TileGrid(int width, int height, int tileSize = TILE_SIZE);
+
+    int getTilesX() const { return m_tilesX; }
+    int getTilesY() const { return m_tilesY; }
+    int getTileCount() const { return m_tilesX * m_tilesY; }
+    int getWidth() const { return m_width; }
+    int getHeight() const { return m_height; }
+    int getTileSize() const { return m_tileSize; }
+
+    Rect getTileRect(int tile) const;
+    const std::vector<unsigned int> &getBin(int tile) const { return m_bins[tile]; }
+
+    void binTriangle(unsigned int triIndex, const BBox &bbox);
+    // add an item to the bin of tile (tx, ty) directly, for callers that find the tiles themselves
+    void binToTile(unsigned int index, int tx, int ty) { m_bins[ty * m_tilesX + tx].push_back(index); }
+    // empty every bin but keep its memory for the next frame
+    void clear();
+
+private:
+    int m_width, m_height;
+    int m_tileSize;
+    int m_tilesX, m_tilesY;
+    std::vector<std::vector<unsigned int>> m_bins;
+};
+
+/*
+    Run body(i) for every i in [0, count) on numThreads worker threads.
+    Work items are handed out one at a time so uneven tiles balance out.
+*/
+void parallelFor(int count, int numThreads, const std::function<void(int)> &body);
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef TRI_H
 #define TRI_H
 
+#include <algorithm>
 #include <iostream>
 #include <vector>
 #include "Vec3.h"
@@ -12,40 +13,24 @@ typedef struct
     float maxX, maxY;
 } BBox;
 
+/*
+    Half-space edge function E(x, y) = a * (x - x0) + b * (y - y0)
+    E is positive on the inside of the edge. Pixels exactly on the edge
+    belong to the triangle only for top and left edges.
+*/
+typedef struct
+{
+    float a, b;
+    float x0, y0;
+    bool topLeft;
+} Edge;
+
 /* triangle */
 class Triangle
 {
 public:
     Triangle(Vec3 v0, Vec3 v1, Vec3 v2)
         : m_v0{v0.getX(), v0.getY(), v0.getZ()}, m_v1{v1.getX(), v1.getY(), v1.getZ()}, m_v2{v2.getX(), v2.getY(), v2.getZ()} {}
-    Triangle(std::vector<float> &posBuf, std::vector<unsigned int> &triBuf, size_t triIndex, float translationX, float translationY, float scale)
-    {
-        int posBufIdx0 = triBuf[triIndex];
-        int posBufIdx1 = triBuf[triIndex + 1];
-        int posBufIdx2 = triBuf[triIndex + 2];
-
-        float x0 = posBuf[3 * posBufIdx0];
-        float y0 = posBuf[3 * posBufIdx0 + 1];
-        float z0 = posBuf[3 * posBufIdx0 + 2];
-        float sx0 = translationX + x0 * scale;
-        float sy0 = translationY + y0 * scale;
-        m_v0 = Vec3(sx0, sy0, z0);
-
-        float x1 = posBuf[3 * posBufIdx1];
-        float y1 = posBuf[3 * posBufIdx1 + 1];
-        float sx1 = translationX + x1 * scale;
-        float sy1 = translationY + y1 * scale;
-        float z1 = posBuf[3 * posBufIdx1 + 2];
-        m_v1 = Vec3(sx1, sy1, z1);
-
-        float x2 = posBuf[3 * posBufIdx2];
-        float y2 = posBuf[3 * posBufIdx2 + 1];
-        float sx2 = translationX + x2 * scale;
-        float sy2 = translationY + y2 * scale;
-        float z2 = posBuf[3 * posBufIdx2 + 2];
-        m_v2 = Vec3(sx2, sy2, z2);
-    }
-
     Vec3 getV0() const { return m_v0; }
     float getX0() const { return m_v0.getX(); }
     float getY0() const { return m_v0.getY(); }
@@ -63,14 +48,24 @@ public:
 
     BBox getBBox() const { return m_BBox; }
 
+    // edge i is the edge opposite vertex i
+    const Edge &getEdge(int i) const { return m_edges[i]; }
+    float getArea() const { return m_area; }
+    // weights of v0, v1 and v2 at (x, y), only valid once the edges are computed
+    void getBarycentrics(float x, float y, float weights[3]) const;
+
     void computeBBox();
+    void clampBBox(int width, int height);
+    bool computeEdges();
 
 private:
     Vec3 m_v0, m_v1, m_v2;
     BBox m_BBox;
+    Edge m_edges[3];
+    float m_area;
 };
 
-void Triangle::computeBBox()
+inline void Triangle::computeBBox()
 {
     m_BBox.minX = m_v0.getX();
     m_BBox.minY = m_v0.getY();
@@ -97,4 +92,51 @@ void Triangle::computeBBox()
         m_BBox.maxY = m_v2.getY();
 }
 
+/* Keep the bounding box inside the pixels of a width x height viewport */
+inline void Triangle::clampBBox(int width, int height)
+{
+    m_BBox.minX = std::max(m_BBox.minX, 0.0f);
+    m_BBox.minY = std::max(m_BBox.minY, 0.0f);
+    m_BBox.maxX = std::min(m_BBox.maxX, static_cast<float>(width - 1));
+    m_BBox.maxY = std::min(m_BBox.maxY, static_cast<float>(height - 1));
+}
+
+inline void Triangle::getBarycentrics(float x, float y, float weights[3]) const
+{
+    for (int i = 0; i < 3; i++)
+        weights[i] = (m_edges[i].a * (x - m_edges[i].x0) + m_edges[i].b * (y - m_edges[i].y0)) / m_area;
+}
+
+inline Edge makeEdge(const Vec3 &from, const Vec3 &to, float sign)
+{
+    Edge edge;
+    edge.a = sign * (from.getY() - to.getY());
+    edge.b = sign * (to.getX() - from.getX());
+    edge.x0 = from.getX();
+    edge.y0 = from.getY();
+    edge.topLeft = edge.a > 0 || (edge.a == 0 && edge.b < 0);
+    return edge;
+}
+
+/*
+    Set up the three edge functions once per triangle so the rasterizer can
+    step them with adds. Both windings are drawn, so the edges are flipped for
+    clockwise triangles to keep the inside positive.
+    Returns false for degenerate (zero area) triangles.
+*/
+inline bool Triangle::computeEdges()
+{
+    m_area = (m_v1.getX() - m_v0.getX()) * (m_v2.getY() - m_v0.getY()) -
+             (m_v2.getX() - m_v0.getX()) * (m_v1.getY() - m_v0.getY());
+    if (m_area == 0)
+        return false;
+
+    float sign = m_area > 0 ? 1.0f : -1.0f;
+    m_edges[0] = makeEdge(m_v1, m_v2, sign);
+    m_edges[1] = makeEdge(m_v2, m_v0, sign);
+    m_edges[2] = makeEdge(m_v0, m_v1, sign);
+    m_area *= sign;
+    return true;
+}
+
 #endif
@@ -0,0 +1,217 @@
+#include <algorithm>
+#include <cmath>
+#include "TriangleSetup.h"
+
+using namespace std;
+
+// A triangle clipped by 6 planes has at most 9 vertices
+static const int MAX_CLIP_VERTS = 9;
+
+/*
+    Homogeneous clip space position, and the weights of the three vertices of
+    the source triangle that give this vertex
+*/
+typedef struct
+{
+    float x, y, z, w;
+    float b[3];
+} ClipVert;
+
+/* Screen space position, source weights and 1 / w */
+typedef struct
+{
+    Vec3 p;
+    float b[3];
+    float invW;
+} ScreenVert;
+
+static void lerpWeights(const float *a, const float *b, float t, float *out)
+{
+	for(int i = 0; i < 3; i++) {
+		out[i] = a[i] + t * (b[i] - a[i]);
+	}
+}
+
+static ClipVert lerp(const ClipVert &a, const ClipVert &b, float t)
+{
+	ClipVert v = {a.x + t * (b.x - a.x), a.y + t * (b.y - a.y), a.z + t * (b.z - a.z), a.w + t * (b.w - a.w), {}};
+	lerpWeights(a.b, b.b, t, v.b);
+	return v;
+}
+
+static ScreenVert lerp(const ScreenVert &a, const ScreenVert &b, float t)
+{
+	ScreenVert v;
+	v.p = Vec3(a.p.getX() + t * (b.p.getX() - a.p.getX()),
+	           a.p.getY() + t * (b.p.getY() - a.p.getY()),
+	           a.p.getZ() + t * (b.p.getZ() - a.p.getZ()));
+	// the weights are linear in screen space only after dividing by w
+	v.invW = a.invW + t * (b.invW - a.invW);
+	for(int i = 0; i < 3; i++) {
+		v.b[i] = (a.b[i] * a.invW + t * (b.b[i] * b.invW - a.b[i] * a.invW)) / v.invW;
+	}
+	return v;
+}
+
+/*
+    One Sutherland-Hodgman pass: keep the part of the polygon where
+    dist(v) >= 0. Works for clip space vertices, and for screen space vertices
+    since depth is linear in screen space after the perspective divide.
+*/
+template <class Vert, class Dist>
+static int clipPolygon(const Vert *in, int count, Vert *out, Dist dist)
+{
+	int outCount = 0;
+	for(int i = 0; i < count; i++) {
+		const Vert &a = in[i];
+		const Vert &b = in[(i + 1) % count];
+		float da = dist(a), db = dist(b);
+		if(da >= 0) {
+			out[outCount++] = a;
+		}
+		if((da >= 0) != (db >= 0)) {
+			out[outCount++] = lerp(a, b, da / (da - db));
+		}
+	}
+	return outCount;
+}
+
+/* Where the triangle being set up came from, for the sources output */
+typedef struct
+{
+    vector<TriangleSource> *sources;
+    const unsigned int *vertices;
+} SourceOutput;
+
+static void emitTriangle(const ScreenVert &v0, const ScreenVert &v1, const ScreenVert &v2, const SetupOptions &options,
+                         vector<Triangle> &out, SetupStats &stats, const SourceOutput &source)
+{
+	Triangle triangle(v0.p, v1.p, v2.p);
+	triangle.computeBBox();
+	triangle.clampBBox(options.width, options.height);
+	triangle.computeEdges();
+	out.push_back(triangle);
+	stats.trianglesOut++;
+	if(source.sources) {
+		TriangleSource ts;
+		const ScreenVert *corners[3] = {&v0, &v1, &v2};
+		for(int i = 0; i < 3; i++) {
+			ts.vertices[i] = source.vertices[i];
+			copy(corners[i]->b, corners[i]->b + 3, ts.weights[i]);
+			ts.invW[i] = corners[i]->invW;
+		}
+		source.sources->push_back(ts);
+	}
+}
+
+/* Cull, reject, guard band clip and emit a convex screen space polygon */
+static void setupScreenPolygon(ScreenVert *poly, int count, bool clipped, const SetupOptions &options,
+                               vector<Triangle> &out, SetupStats &stats, const SourceOutput &source)
+{
+	// signed area, positive for counter-clockwise polygons
+	float area = 0;
+	for(int i = 1; i + 1 < count; i++) {
+		area += (poly[i].p.getX() - poly[0].p.getX()) * (poly[i + 1].p.getY() - poly[0].p.getY()) -
+		        (poly[i + 1].p.getX() - poly[0].p.getX()) * (poly[i].p.getY() - poly[0].p.getY());
+	}
+	if((options.cull == CULL_CW && area <= 0) || (options.cull == CULL_CCW && area >= 0)) {
+		stats.culled++;
+		return;
+	}
+
+	// trivial reject against the viewport
+	float minX = poly[0].p.getX(), maxX = poly[0].p.getX();
+	float minY = poly[0].p.getY(), maxY = poly[0].p.getY();
+	for(int i = 1; i < count; i++) {
+		minX = min(minX, poly[i].p.getX());
+		maxX = max(maxX, poly[i].p.getX());
+		minY = min(minY, poly[i].p.getY());
+		maxY = max(maxY, poly[i].p.getY());
+	}
+	if(maxX < 0 || maxY < 0 || minX > options.width - 1 || minY > options.height - 1) {
+		stats.outside++;
+		return;
+	}
+
+	float guardMinX = -GUARD_BAND, guardMaxX = options.width - 1 + GUARD_BAND;
+	float guardMinY = -GUARD_BAND, guardMaxY = options.height - 1 + GUARD_BAND;
+	ScreenVert buf[MAX_CLIP_VERTS];
+	if(minX < guardMinX || maxX > guardMaxX || minY < guardMinY || maxY > guardMaxY) {
+		count = clipPolygon(poly, count, buf, [&](const ScreenVert &v) { return v.p.getX() - guardMinX; });
+		count = clipPolygon(buf, count, poly, [&](const ScreenVert &v) { return guardMaxX - v.p.getX(); });
+		count = clipPolygon(poly, count, buf, [&](const ScreenVert &v) { return v.p.getY() - guardMinY; });
+		count = clipPolygon(buf, count, poly, [&](const ScreenVert &v) { return guardMaxY - v.p.getY(); });
+		clipped = true;
+	}
+	if(clipped) {
+		stats.clipped++;
+	}
+
+	// the clipped polygon is convex, so a fan keeps the original winding
+	for(int i = 1; i + 1 < count; i++) {
+		emitTriangle(poly[0], poly[i], poly[i + 1], options, out, stats, source);
+	}
+}
+
+void setupTriangle(const PostTransformBuffer &verts, unsigned int i0, unsigned int i1, unsigned int i2,
+                   const SetupOptions &options, vector<Triangle> &out, SetupStats &stats,
+                   vector<TriangleSource> *sources)
+{
+	stats.trianglesIn++;
+	const unsigned int index[3] = {i0, i1, i2};
+	SourceOutput source = {sources, index};
+
+	// distance to the near plane -z / w <= zNear, and to the w > 0 plane
+	bool nearClip = !isinf(options.zNear);
+	auto nearDist = [&](const ClipVert &v) { return options.zNear * v.w + v.z; };
+	auto eyeDist = [&](const ClipVert &v) { return v.w - W_EPSILON; };
+
+	ClipVert clip[3];
+	int inside = 0;
+	for(int i = 0; i < 3; i++) {
+		unsigned int v = index[i];
+		clip[i] = {verts.clipX[v], verts.clipY[v], verts.clipZ[v], verts.clipW[v], {0, 0, 0}};
+		clip[i].b[i] = 1.0f;
+		if(eyeDist(clip[i]) >= 0 && (!nearClip || nearDist(clip[i]) >= 0)) {
+			inside++;
+		}
+	}
+
+	ScreenVert poly[MAX_CLIP_VERTS];
+	if(inside == 3) {
+		// the common case: use the screen positions from the vertex stage
+		for(int i = 0; i < 3; i++) {
+			unsigned int v = index[i];
+			poly[i].p = Vec3(verts.screenX[v], verts.screenY[v], verts.depth[v]);
+			copy(clip[i].b, clip[i].b + 3, poly[i].b);
+			poly[i].invW = 1.0f / verts.clipW[v];
+		}
+		setupScreenPolygon(poly, 3, false, options, out, stats, source);
+		return;
+	}
+	if(inside == 0) {
+		stats.outside++;
+		return;
+	}
+
+	ClipVert bufA[MAX_CLIP_VERTS], bufB[MAX_CLIP_VERTS];
+	copy(clip, clip + 3, bufA);
+	int count = clipPolygon(bufA, 3, bufB, eyeDist);
+	if(nearClip) {
+		count = clipPolygon(bufB, count, bufA, nearDist);
+		copy(bufA, bufA + count, bufB);
+	}
+	if(count < 3) {
+		stats.outside++;
+		return;
+	}
+
+	const Viewport &vp = options.viewport;
+	for(int i = 0; i < count; i++) {
+		const ClipVert &c = bufB[i];
+		poly[i].p = Vec3(vp.translationX + (c.x / c.w) * vp.scaleX, vp.translationY + (c.y / c.w) * vp.scaleY, -(c.z / c.w));
+		copy(c.b, c.b + 3, poly[i].b);
+		poly[i].invW = 1.0f / c.w;
+	}
+	setupScreenPolygon(poly, count, true, options, out, stats, source);
+}
@@ -0,0 +1,69 @@
+#ifndef TRIANGLE_SETUP_H
+#define TRIANGLE_SETUP_H
+
+#include <vector>
+#include "Triangle.h"
+#include "VertexStage.h"
+
+/* Which screen space winding is thrown away, y points up */
+enum CullMode
+{
+    CULL_NONE,
+    CULL_CW,
+    CULL_CCW
+};
+
+/* Pixels a triangle may reach past each side of the viewport before it is clipped */
+const float GUARD_BAND = 4096.0f;
+
+/* Vertices with a smaller clip space w are treated as behind the eye */
+const float W_EPSILON = 1e-5f;
+
+typedef struct
+{
+    int width, height;
+    Viewport viewport;
+    CullMode cull;
+    // anything closer than this depth (-z / w larger than zNear) is clipped away
+    float zNear;
+} SetupOptions;
+
+typedef struct
+{
+    size_t trianglesIn;
+    size_t culled;    // back facing or degenerate
+    size_t outside;   // entirely off screen or behind the near plane
+    size_t clipped;   // split against the near plane or the guard band
+    size_t trianglesOut;
+} SetupStats;
+
+/*
+    Where a set up triangle came from, for the shading modes that interpolate
+    vertex attributes: the three vertices of its stream triangle and, for
+    each of its own vertices, the weights of those three and 1 / w, which
+    makes the interpolation perspective correct. A triangle that was not
+    clipped has the identity weights.
+*/
+typedef struct
+{
+    unsigned int vertices[3];
+    float weights[3][3];
+    float invW[3];
+} TriangleSource;
+
+/*
+    Triangle setup for the triangle made of vertices i0, i1 and i2 of the
+    post-transform buffer. Vertices past the near plane or behind the eye are
+    clipped in clip space before the perspective divide. The screen space
+    triangle is then culled by the sign of its area, dropped when it is
+    completely outside the viewport, clipped against the guard band when it
+    reaches past it, and the bounding box of every resulting triangle is
+    clamped to the viewport. The triangles that survive are appended to out
+    with their edges computed. When sources is given, one TriangleSource is
+    appended to it for every triangle appended to out.
+*/
+void setupTriangle(const PostTransformBuffer &verts, unsigned int i0, unsigned int i1, unsigned int i2,
+                   const SetupOptions &options, std::vector<Triangle> &out, SetupStats &stats,
+                   std::vector<TriangleSource> *sources = nullptr);
+
+#endif
@@ -0,0 +1,88 @@
+#include <cmath>
+#include "TriangleStream.h"
+
+using namespace std;
+
+/* Area weighted face normals summed at the vertices [base, end) */
+static void computeNormals(TriangleStream &stream, size_t base, size_t firstIndex)
+{
+	size_t end = stream.x.size();
+	stream.nx.resize(end, 0.0f);
+	stream.ny.resize(end, 0.0f);
+	stream.nz.resize(end, 0.0f);
+	for(size_t i = firstIndex; i + 2 < stream.indices.size(); i += 3) {
+		unsigned int a = stream.indices[i], b = stream.indices[i + 1], c = stream.indices[i + 2];
+		float ux = stream.x[b] - stream.x[a], uy = stream.y[b] - stream.y[a], uz = stream.z[b] - stream.z[a];
+		float vx = stream.x[c] - stream.x[a], vy = stream.y[c] - stream.y[a], vz = stream.z[c] - stream.z[a];
+		// the cross product is twice the area long
+		float nx = uy * vz - uz * vy, ny = uz * vx - ux * vz, nz = ux * vy - uy * vx;
+		for(unsigned int v : {a, b, c}) {
+			stream.nx[v] += nx;
+			stream.ny[v] += ny;
+			stream.nz[v] += nz;
+		}
+	}
+	for(size_t v = base; v < end; v++) {
+		float length = sqrt(stream.nx[v] * stream.nx[v] + stream.ny[v] * stream.ny[v] + stream.nz[v] * stream.nz[v]);
+		if(length > 0) {
+			stream.nx[v] /= length;
+			stream.ny[v] /= length;
+			stream.nz[v] /= length;
+		}
+	}
+}
+
+void flattenShapes(vector<tinyobj::shape_t> &shapes, TriangleStream &stream, bool withNormals)
+{
+	size_t numVertices = 0, numIndices = 0;
+	for(const auto &shape : shapes) {
+		numVertices += shape.mesh.positions.size() / 3;
+		numIndices += shape.mesh.indices.size();
+	}
+	stream.x.reserve(stream.x.size() + numVertices);
+	stream.y.reserve(stream.y.size() + numVertices);
+	stream.z.reserve(stream.z.size() + numVertices);
+	if(withNormals) {
+		stream.nx.reserve(stream.nx.size() + numVertices);
+		stream.ny.reserve(stream.ny.size() + numVertices);
+		stream.nz.reserve(stream.nz.size() + numVertices);
+	}
+	stream.indices.reserve(stream.indices.size() + numIndices);
+	stream.shapeIds.reserve(stream.shapeIds.size() + numIndices / 3);
+	stream.materialIds.reserve(stream.materialIds.size() + numIndices / 3);
+
+	for(size_t s = 0; s < shapes.size(); s++) {
+		tinyobj::mesh_t &mesh = shapes[s].mesh;
+		unsigned int base = static_cast<unsigned int>(stream.x.size());
+		size_t firstIndex = stream.indices.size();
+		for(size_t v = 0; v + 2 < mesh.positions.size(); v += 3) {
+			stream.x.push_back(mesh.positions[v + 0]);
+			stream.y.push_back(mesh.positions[v + 1]);
+			stream.z.push_back(mesh.positions[v + 2]);
+		}
+		for(unsigned int index : mesh.indices) {
+			stream.indices.push_back(base + index);
+		}
+		if(withNormals) {
+			if(mesh.normals.size() == mesh.positions.size()) {
+				for(size_t v = 0; v + 2 < mesh.normals.size(); v += 3) {
+					stream.nx.push_back(mesh.normals[v + 0]);
+					stream.ny.push_back(mesh.normals[v + 1]);
+					stream.nz.push_back(mesh.normals[v + 2]);
+				}
+			} else {
+				computeNormals(stream, base, firstIndex);
+			}
+		}
+		size_t numTriangles = mesh.indices.size() / 3;
+		for(size_t t = 0; t < numTriangles; t++) {
+			stream.shapeIds.push_back(static_cast<unsigned int>(s));
+			stream.materialIds.push_back(t < mesh.material_ids.size() ? mesh.material_ids[t] : -1);
+		}
+
+		// swap with empty vectors to actually give the memory back
+		vector<float>().swap(mesh.positions);
+		vector<float>().swap(mesh.normals);
+		vector<unsigned int>().swap(mesh.indices);
+	}
+}
@@ -0,0 +1,35 @@
+#ifndef TRIANGLE_STREAM_H
+#define TRIANGLE_STREAM_H
+
+#include <vector>
+#include "tiny_obj_loader.h"
+
+/*
+    Every shape of an OBJ flattened into one indexed triangle list.
+    Positions are kept as separate x, y and z arrays and the indices of each
+    shape are rebased so they point straight into them. Each triangle records
+    the shape it came from and its material id (-1 for none).
+    Vertex normals are only kept when asked for, see flattenShapes.
+*/
+struct TriangleStream
+{
+    std::vector<float> x, y, z;
+    std::vector<float> nx, ny, nz;
+    std::vector<unsigned int> indices;
+    std::vector<unsigned int> shapeIds;
+    std::vector<int> materialIds;
+
+    size_t getVertexCount() const { return x.size(); }
+    size_t getTriangleCount() const { return indices.size() / 3; }
+};
+
+/*
+    Move all shapes into one stream. The geometry buffers of each shape are
+    released as soon as they have been copied, so the mesh is only held twice
+    for one shape at a time. With withNormals the vertex normals of the OBJ
+    are copied too; a shape without them gets normals averaged from the
+    faces around each vertex, weighted by area.
+*/
+void flattenShapes(std::vector<tinyobj::shape_t> &shapes, TriangleStream &stream, bool withNormals = false);
+
+#endif
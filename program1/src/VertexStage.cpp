@@ -0,0 +1,123 @@
+#include <algorithm>
+#include "VertexStage.h"
+#include "Tiles.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_AVX_VERTEX_KERNEL
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// vertices per work item handed to a thread
+static const size_t CHUNK_SIZE = 1 << 14;
+
+void PostTransformBuffer::resize(size_t count)
+{
+	clipX.resize(count);
+	clipY.resize(count);
+	clipZ.resize(count);
+	clipW.resize(count);
+	screenX.resize(count);
+	screenY.resize(count);
+	depth.resize(count);
+}
+
+// Every product is added in column order so all kernels round identically
+static void transformScalar(const TriangleStream &s, const Mat4 &mvp, const Viewport &vp,
+                            PostTransformBuffer &out, size_t begin, size_t end)
+{
+	const float (*m)[4] = mvp.m;
+	for(size_t i = begin; i < end; i++) {
+		float x = s.x[i], y = s.y[i], z = s.z[i];
+		float cx = m[0][0] * x + m[0][1] * y + m[0][2] * z + m[0][3];
+		float cy = m[1][0] * x + m[1][1] * y + m[1][2] * z + m[1][3];
+		float cz = m[2][0] * x + m[2][1] * y + m[2][2] * z + m[2][3];
+		float cw = m[3][0] * x + m[3][1] * y + m[3][2] * z + m[3][3];
+		out.clipX[i] = cx;
+		out.clipY[i] = cy;
+		out.clipZ[i] = cz;
+		out.clipW[i] = cw;
+		out.screenX[i] = vp.translationX + (cx / cw) * vp.scaleX;
+		out.screenY[i] = vp.translationY + (cy / cw) * vp.scaleY;
+		out.depth[i] = -(cz / cw);
+	}
+}
+
+#ifdef HAVE_AVX_VERTEX_KERNEL
+
+__attribute__((target("avx")))
+static inline __m256 transformRow(const float *row, __m256 x, __m256 y, __m256 z)
+{
+	__m256 r = _mm256_mul_ps(_mm256_set1_ps(row[0]), x);
+	r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_set1_ps(row[1]), y));
+	r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_set1_ps(row[2]), z));
+	return _mm256_add_ps(r, _mm256_set1_ps(row[3]));
+}
+
+// No FMA in the target list so the results match the scalar kernel
+__attribute__((target("avx")))
+static void transformAVX(const TriangleStream &s, const Mat4 &mvp, const Viewport &vp,
+                         PostTransformBuffer &out, size_t begin, size_t end)
+{
+	const __m256 signFlip = _mm256_set1_ps(-0.0f);
+	size_t i = begin;
+	for(; i + 8 <= end; i += 8) {
+		__m256 x = _mm256_loadu_ps(&s.x[i]);
+		__m256 y = _mm256_loadu_ps(&s.y[i]);
+		__m256 z = _mm256_loadu_ps(&s.z[i]);
+		__m256 cx = transformRow(mvp.m[0], x, y, z);
+		__m256 cy = transformRow(mvp.m[1], x, y, z);
+		__m256 cz = transformRow(mvp.m[2], x, y, z);
+		__m256 cw = transformRow(mvp.m[3], x, y, z);
+		_mm256_storeu_ps(&out.clipX[i], cx);
+		_mm256_storeu_ps(&out.clipY[i], cy);
+		_mm256_storeu_ps(&out.clipZ[i], cz);
+		_mm256_storeu_ps(&out.clipW[i], cw);
+		__m256 sx = _mm256_mul_ps(_mm256_div_ps(cx, cw), _mm256_set1_ps(vp.scaleX));
+		__m256 sy = _mm256_mul_ps(_mm256_div_ps(cy, cw), _mm256_set1_ps(vp.scaleY));
+		_mm256_storeu_ps(&out.screenX[i], _mm256_add_ps(_mm256_set1_ps(vp.translationX), sx));
+		_mm256_storeu_ps(&out.screenY[i], _mm256_add_ps(_mm256_set1_ps(vp.translationY), sy));
+		_mm256_storeu_ps(&out.depth[i], _mm256_xor_ps(_mm256_div_ps(cz, cw), signFlip));
+	}
+	transformScalar(s, mvp, vp, out, i, end);
+}
+
+static bool useAVX(bool forceScalar)
+{
+	return !forceScalar && __builtin_cpu_supports("avx");
+}
+
+#else
+
+static bool useAVX(bool forceScalar)
+{
+	return false;
+}
+
+#endif
+
+void transformVertices(const TriangleStream &stream, const Mat4 &mvp, const Viewport &viewport,
+                       PostTransformBuffer &out, int numThreads, bool forceScalar)
+{
+	size_t count = stream.getVertexCount();
+	out.resize(count);
+	bool avx = useAVX(forceScalar);
+	int chunks = static_cast<int>((count + CHUNK_SIZE - 1) / CHUNK_SIZE);
+	parallelFor(chunks, numThreads, [&](int chunk) {
+		size_t begin = chunk * CHUNK_SIZE;
+		size_t end = min(begin + CHUNK_SIZE, count);
+#ifdef HAVE_AVX_VERTEX_KERNEL
+		if(avx) {
+			transformAVX(stream, mvp, viewport, out, begin, end);
+			return;
+		}
+#endif
+		transformScalar(stream, mvp, viewport, out, begin, end);
+	});
+}
+
+const char *getVertexKernelName(bool forceScalar)
+{
+	return useAVX(forceScalar) ? "avx" : "scalar";
+}
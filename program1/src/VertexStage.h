@@ -0,0 +1,40 @@
+#ifndef VERTEX_STAGE_H
+#define VERTEX_STAGE_H
+
+#include <vector>
+#include "Mat4.h"
+#include "TriangleStream.h"
+
+/* Maps normalized device coordinates to pixels: x = translationX + ndcX * scaleX */
+typedef struct
+{
+    float translationX, translationY;
+    float scaleX, scaleY;
+} Viewport;
+
+/*
+    Every unique vertex of a TriangleStream after the vertex stage.
+    The clip space position is kept for clipping; the screen position and
+    depth are the result of the perspective divide and the viewport transform
+    and are only meaningful when clipW > 0. Depth is -z / w, so larger is closer.
+*/
+struct PostTransformBuffer
+{
+    std::vector<float> clipX, clipY, clipZ, clipW;
+    std::vector<float> screenX, screenY, depth;
+
+    size_t size() const { return clipX.size(); }
+    void resize(size_t count);
+};
+
+/*
+    Transform all vertices of the stream by mvp exactly once. Vertices are
+    processed 8 at a time with AVX when the CPU supports it, in chunks spread
+    over numThreads threads. The result does not depend on the kernel used.
+*/
+void transformVertices(const TriangleStream &stream, const Mat4 &mvp, const Viewport &viewport,
+                       PostTransformBuffer &out, int numThreads, bool forceScalar);
+
+const char *getVertexKernelName(bool forceScalar);
+
+#endif
@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <iostream>
+#include "VisibilityBuffer.h"
+#include "Image.h"
+
+using namespace std;
+
+VisibilityBuffer::VisibilityBuffer(int width, int height, BufferLayout layout, bool ids, bool overdraw) :
+	m_width(width),
+	m_height(height),
+	m_originY(0),
+	m_layout(layout, width, height)
+{
+	if(ids) {
+		m_ids.assign(m_layout.getSize(), NO_TRIANGLE);
+	}
+	if(overdraw) {
+		m_overdraw.assign(m_layout.getSize(), 0);
+	}
+}
+
+void VisibilityBuffer::writeSpan(int x, int y, int count, unsigned int triIndex, unsigned int mask)
+{
+	size_t offset = m_layout.offset(x, y - m_originY);
+	if(!m_ids.empty()) {
+		unsigned int *ids = &m_ids[offset];
+		for(int i = 0; i < count; i++) {
+			// all ones when the pixel passed, zero when it keeps its id
+			unsigned int take = 0u - ((mask >> i) & 1u);
+			ids[i] = (triIndex & take) | (ids[i] & ~take);
+		}
+	}
+	if(!m_overdraw.empty()) {
+		unsigned int *counts = &m_overdraw[offset];
+		for(int i = 0; i < count; i++) {
+			counts[i] += (mask >> i) & 1u;
+		}
+	}
+}
+
+void VisibilityBuffer::clear()
+{
+	fill(m_ids.begin(), m_ids.end(), NO_TRIANGLE);
+	fill(m_overdraw.begin(), m_overdraw.end(), 0);
+}
+
+/* black, blue, cyan, green, yellow, red */
+static void heatColor(float t, unsigned char *rgb)
+{
+	static const float ramp[6][3] = {{0, 0, 0}, {0, 0, 255}, {0, 255, 255}, {0, 255, 0}, {255, 255, 0}, {255, 0, 0}};
+	float position = t * 5.0f;
+	int i = min(static_cast<int>(position), 4);
+	float f = position - i;
+	for(int c = 0; c < 3; c++) {
+		rgb[c] = static_cast<unsigned char>(ramp[i][c] + (ramp[i + 1][c] - ramp[i][c]) * f + 0.5f);
+	}
+}
+
+void VisibilityBuffer::writeOverdraw(const string &filename, int numThreads) const
+{
+	if(m_overdraw.empty()) {
+		return;
+	}
+	unsigned int maxCount = 0;
+	unsigned long long total = 0, covered = 0;
+	for(int y = 0; y < m_height; y++) {
+		for(int x = 0; x < m_width; x++) {
+			unsigned int count = m_overdraw[m_layout.offset(x, y)];
+			maxCount = max(maxCount, count);
+			total += count;
+			covered += count > 0;
+		}
+	}
+	cout << "Overdraw: at most " << maxCount << ", " << (covered ? double(total) / covered : 0.0)
+	     << " depth test passes per covered pixel" << endl;
+
+	// counts are stored bottom row first like the depth buffer, the heatmap
+	// is drawn with the same convention
+	Image heatmap(m_width, m_height);
+	unsigned char rgb[3];
+	for(int y = 0; y < m_height; y++) {
+		for(int x = 0; x < m_width; x++) {
+			unsigned int count = m_overdraw[m_layout.offset(x, y)];
+			heatColor(maxCount ? float(count) / maxCount : 0.0f, rgb);
+			heatmap.writeSpan(x, y, 1, rgb);
+		}
+	}
+	heatmap.writeToFile(filename, numThreads);
+}
@@ -0,0 +1,47 @@
+#ifndef VISIBILITY_BUFFER_H
+#define VISIBILITY_BUFFER_H
+
+#include <string>
+#include <vector>
+#include "BufferLayout.h"
+
+/* Triangle id of a pixel no triangle covers */
+const unsigned int NO_TRIANGLE = 0xffffffffu;
+
+/*
+    Per-pixel planes that sit next to the depth buffer, same size, layout and
+    origin. The id plane holds the index of the triangle that last passed the
+    depth test, so shading can be done once per pixel after rasterization.
+    The overdraw plane counts how often every pixel passed the depth test,
+    which is how often forward shading would have run there.
+    Each plane is only allocated when it is asked for.
+*/
+class VisibilityBuffer
+{
+public:
+    VisibilityBuffer(int width, int height, BufferLayout layout, bool ids, bool overdraw);
+
+    bool hasIds() const { return !m_ids.empty(); }
+    bool hasOverdraw() const { return !m_overdraw.empty(); }
+    bool isEnabled() const { return hasIds() || hasOverdraw(); }
+
+    unsigned int getId(int x, int y) const { return m_ids[m_layout.offset(x, y - m_originY)]; }
+    // record triIndex for pixel x + i when bit i of mask is set; the span must not cross a tile column
+    void writeSpan(int x, int y, int count, unsigned int triIndex, unsigned int mask);
+
+    // see DepthBuffer::setOriginY
+    void setOriginY(int y) { m_originY = y; }
+    void clear();
+
+    // write the overdraw counts as a color ramp image, black for 0 up to red for the maximum
+    void writeOverdraw(const std::string &filename, int numThreads) const;
+
+private:
+    int m_width, m_height;
+    int m_originY;
+    PixelLayout m_layout;
+    std::vector<unsigned int> m_ids;
+    std::vector<unsigned int> m_overdraw;
+};
+
+#endif
@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_set>
+#include "PixelKernel.h"
+#include "Wireframe.h"
+
+using namespace std;
+
+namespace {
+
+// Both end points as raw float bits, smaller end point first
+struct EdgeKey
+{
+	uint32_t bits[6];
+	bool operator==(const EdgeKey &other) const { return memcmp(bits, other.bits, sizeof(bits)) == 0; }
+};
+
+struct EdgeKeyHash
+{
+	size_t operator()(const EdgeKey &key) const
+	{
+		uint64_t h = 14695981039346656037ull;
+		for(int i = 0; i < 6; i++) {
+			h = (h ^ key.bits[i]) * 1099511628211ull;
+		}
+		return static_cast<size_t>(h ^ (h >> 32));
+	}
+};
+
+bool lessPoint(const Vec3 &p, const Vec3 &q)
+{
+	if(p.getX() != q.getX()) {
+		return p.getX() < q.getX();
+	}
+	if(p.getY() != q.getY()) {
+		return p.getY() < q.getY();
+	}
+	return p.getZ() < q.getZ();
+}
+
+LineEdge makeEdge(Vec3 p, Vec3 q)
+{
+	if(lessPoint(q, p)) {
+		swap(p, q);
+	}
+	LineEdge edge = {p.getX(), p.getY(), p.getZ(), q.getX(), q.getY(), q.getZ()};
+	return edge;
+}
+
+EdgeKey makeKey(const LineEdge &edge)
+{
+	EdgeKey key;
+	memcpy(key.bits, &edge, sizeof(key.bits));
+	return key;
+}
+
+// Pixel centers are at integer coordinates
+int nearestPixel(float v)
+{
+	return static_cast<int>(floor(v + 0.5f));
+}
+
+// The edge with its major axis as a and minor axis as b, a0 <= a1
+struct MajorAxis
+{
+	bool steep;
+	float a0, b0, z0;
+	float a1, b1, z1;
+
+	explicit MajorAxis(const LineEdge &edge)
+	{
+		steep = fabs(edge.y1 - edge.y0) > fabs(edge.x1 - edge.x0);
+		a0 = steep ? edge.y0 : edge.x0;
+		b0 = steep ? edge.x0 : edge.y0;
+		a1 = steep ? edge.y1 : edge.x1;
+		b1 = steep ? edge.x1 : edge.y1;
+		z0 = edge.z0;
+		z1 = edge.z1;
+		if(a0 > a1) {
+			swap(a0, a1);
+			swap(b0, b1);
+			swap(z0, z1);
+		}
+	}
+
+	// change in b and z per pixel along a
+	float slope() const { return a1 > a0 ? (b1 - b0) / (a1 - a0) : 0.0f; }
+	float zSlope() const { return a1 > a0 ? (z1 - z0) / (a1 - a0) : 0.0f; }
+};
+
+}
+
+void extractEdges(const vector<Triangle> &triangles, vector<LineEdge> &edges)
+{
+	edges.clear();
+	unordered_set<EdgeKey, EdgeKeyHash> seen;
+	seen.reserve(triangles.size() * 2);
+	for(const Triangle &triangle : triangles) {
+		LineEdge sides[3] = {
+			makeEdge(triangle.getV0(), triangle.getV1()),
+			makeEdge(triangle.getV1(), triangle.getV2()),
+			makeEdge(triangle.getV2(), triangle.getV0())
+		};
+		for(const LineEdge &edge : sides) {
+			if(seen.insert(makeKey(edge)).second) {
+				edges.push_back(edge);
+			}
+		}
+	}
+}
+
+void binEdges(const vector<LineEdge> &edges, TileGrid &grid)
+{
+	grid.clear();
+	int tileSize = grid.getTileSize();
+	for(size_t i = 0; i < edges.size(); i++) {
+		MajorAxis axis(edges[i]);
+		int majorSize = axis.steep ? grid.getHeight() : grid.getWidth();
+		int minorSize = axis.steep ? grid.getWidth() : grid.getHeight();
+		int first = max(nearestPixel(axis.a0), 0);
+		int last = min(nearestPixel(axis.a1), majorSize - 1);
+		float slope = axis.slope();
+
+		for(int t = first / tileSize; first <= last && t <= last / tileSize; t++) {
+			// the minor coordinate over the pixels of this tile column, with a
+			// pixel of margin for rounding and the second pixel of smooth lines
+			int p0 = max(first, t * tileSize), p1 = min(last, t * tileSize + tileSize - 1);
+			float b0 = axis.b0 + (p0 - axis.a0) * slope, b1 = axis.b0 + (p1 - axis.a0) * slope;
+			int minB = max(static_cast<int>(floor(min(b0, b1))) - 1, 0);
+			int maxB = min(static_cast<int>(ceil(max(b0, b1))) + 1, minorSize - 1);
+			for(int u = minB / tileSize; minB <= maxB && u <= maxB / tileSize; u++) {
+				if(axis.steep) {
+					grid.binToTile(static_cast<unsigned int>(i), u, t);
+				} else {
+					grid.binToTile(static_cast<unsigned int>(i), t, u);
+				}
+			}
+		}
+	}
+}
+
+void drawEdge(const LineEdge &edge, shared_ptr<Image> outImage, DepthBuffer &depth, const Rect &clip, bool smooth,
+              EdgeCounts &counts)
+{
+	MajorAxis axis(edge);
+	int clipA0 = axis.steep ? clip.minY : clip.minX, clipA1 = axis.steep ? clip.maxY : clip.maxX;
+	int clipB0 = axis.steep ? clip.minX : clip.minY, clipB1 = axis.steep ? clip.maxX : clip.maxY;
+	int first = max(nearestPixel(axis.a0), clipA0);
+	int last = min(nearestPixel(axis.a1), clipA1);
+	if(first > last) {
+		return;
+	}
+
+	// start at the first pixel inside the clip rectangle, then only add
+	float slope = axis.slope(), dz = axis.zSlope();
+	int64_t b = llround((axis.b0 + (first - axis.a0) * slope) * 65536.0);
+	int64_t bStep = llround(slope * 65536.0);
+	float z = axis.z0 + (first - axis.a0) * dz;
+
+	unsigned char rgb[3];
+	for(int a = first; a <= last; a++, b += bStep, z += dz) {
+		if(!smooth) {
+			int pixel = static_cast<int>((b + 0x8000) >> 16);
+			if(pixel < clipB0 || pixel > clipB1) {
+				continue;
+			}
+			int x = axis.steep ? pixel : a, y = axis.steep ? a : pixel;
+			float &zPixel = depth.at(x, y);
+			counts.pixelsTested++;
+			if(z > zPixel) {
+				counts.depthPasses++;
+				zPixel = z;
+				shadeDepth(z, rgb);
+				outImage->writeSpan(x, y, 1, rgb);
+			}
+			continue;
+		}
+
+		// the pixel below the line and the one above it, weighted by distance
+		int below = static_cast<int>(b >> 16);
+		float frac = (b & 0xffff) / 65536.0f;
+		for(int k = 0; k < 2; k++) {
+			int pixel = below + k;
+			float coverage = k ? frac : 1.0f - frac;
+			if(coverage <= 0.0f || pixel < clipB0 || pixel > clipB1) {
+				continue;
+			}
+			int x = axis.steep ? pixel : a, y = axis.steep ? a : pixel;
+			float &zPixel = depth.at(x, y);
+			counts.pixelsTested++;
+			if(z > zPixel) {
+				counts.depthPasses++;
+				if(coverage >= 0.5f) {
+					zPixel = z;
+				}
+				shadeDepth(z, rgb);
+				unsigned char *dst = outImage->getSpan(x, y);
+				for(int c = 0; c < 3; c++) {
+					dst[c] = static_cast<unsigned char>(dst[c] + (rgb[c] - dst[c]) * coverage + 0.5f);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,53 @@
+#ifndef WIREFRAME_H
+#define WIREFRAME_H
+
+#include <memory>
+#include <vector>
+#include "DepthBuffer.h"
+#include "Image.h"
+#include "Tiles.h"
+#include "Triangle.h"
+
+/* One screen space line of the wireframe, from (x0, y0, z0) to (x1, y1, z1) */
+typedef struct
+{
+    float x0, y0, z0;
+    float x1, y1, z1;
+} LineEdge;
+
+/* Pixels drawEdge stepped over and pixels that passed the depth test */
+typedef struct
+{
+    long long pixelsTested, depthPasses;
+} EdgeCounts;
+
+/*
+    Collect every edge of the set up triangles exactly once. Neighbouring
+    triangles share their transformed vertices bit for bit, so a shared edge
+    is found by hashing its two end points. The end points are put in a fixed
+    order, which makes an edge draw the same pixels whichever triangle it
+    came from. Edges keep the order in which they are first met.
+*/
+void extractEdges(const std::vector<Triangle> &triangles, std::vector<LineEdge> &edges);
+
+/*
+    Bin every edge into the tiles it passes through. The tiles are found by
+    walking the edge one tile column (or row, for steep edges) at a time, so a
+    long diagonal edge is not added to every tile of its bounding box.
+*/
+void binEdges(const std::vector<LineEdge> &edges, TileGrid &grid);
+
+/*
+    Draw the part of an edge inside the clip rectangle, depth tested and
+    colored by depth. The edge is walked one pixel at a time along its major
+    axis with the minor coordinate in 16.16 fixed point and the depth stepped
+    by a constant, so there is no divide per pixel. Pixel centers are at
+    integer coordinates, the same as for filled triangles. With smooth the
+    line is anti-aliased: the two pixels straddling the line are blended by
+    how close they are to it, and only the nearer one writes depth. The
+    pixels are added to counts.
+*/
+void drawEdge(const LineEdge &edge, std::shared_ptr<Image> outImage, DepthBuffer &depth, const Rect &clip,
+              bool smooth, EdgeCounts &counts);
+
+#endif
@@ -4,11 +4,32 @@
 #include <string>
 #include <vector>
 #include <memory>
-#include <assert.h>
+#include <thread>
+#include <atomic>
+#include <fstream>
+#include <chrono>
+#include <bitset>
 
 #include "tiny_obj_loader.h"
 #include "Image.h"
 #include "Triangle.h"
+#include "Tiles.h"
+#include "PixelKernel.h"
+#include "DepthBuffer.h"
+#include "RasterSetup.h"
+#include "TriangleStream.h"
+#include "TriangleSetup.h"
+#include "VertexStage.h"
+#include "Camera.h"
+#include "ImageWriter.h"
+#include "BufferLayout.h"
+#include "CacheCounters.h"
+#include "VisibilityBuffer.h"
+#include "Shaders.h"
+#include "Samples.h"
+#include "Wireframe.h"
+#include "MeshBounds.h"
+#include "RunStats.h"
 
 // This allows you to skip the `std::` in front of C++ standard library
 // functions. You can also say `using std::cout` to be more selective.
@@ -16,207 +37,913 @@
 using namespace std;
 
 int g_width, g_height;
+// pixel kernel used by mode 0, picked at startup
+ShadeRowFn g_shadeRow = shadeRowScalar;
+bool g_useHiZ = true;
+// snap vertices to a subpixel grid and rasterize with integer edge functions
+bool g_fixedPoint = false;
+// anti-aliasing: samples per pixel (1 for none), and whether every sample is
+// shaded (supersampling) or only one per pixel and triangle (multisampling)
+int g_samples = 1;
+bool g_superSample = false;
+// anti-alias the lines of mode 1
+bool g_smoothLines = false;
+// stage timings and counters for --stats
+RunStats g_stats;
+
+/*
+    Hierarchical z culling and raster counters, shared by all tile workers
+    A triangle counts as culled when some of its blocks reached the depth test
+    but every one of them was rejected by the coarse depth level. Pixels
+    tested are the pixels of the blocks the pixel kernels ran on, the pixels
+    the anti-aliased path tested samples of, or the pixels the wireframe
+    stepped over. With anti-aliasing a pixel passes the depth test once when
+    any of its samples does.
+*/
+const unsigned char TRI_REACHED = 1, TRI_DRAWN = 2;
+struct CullStats
+{
+    CullStats() : blocksTested(0), blocksCulled(0), pixelsTested(0), depthPasses(0), numTriangles(0), capacity(0) {}
+
+    // zero the counters for a frame of numTriangles triangles, reusing the flags when they fit
+    void reset(size_t count)
+    {
+        if (count > capacity)
+        {
+            triFlags.reset(new atomic<unsigned char>[count]);
+            capacity = count;
+        }
+        numTriangles = count;
+        for (size_t i = 0; i < count; i++)
+            triFlags[i].store(0);
+        blocksTested = 0;
+        blocksCulled = 0;
+        pixelsTested = 0;
+        depthPasses = 0;
+    }
+
+    atomic<long long> blocksTested, blocksCulled, pixelsTested, depthPasses;
+    unique_ptr<atomic<unsigned char>[]> triFlags;
+    size_t numTriangles, capacity;
+};
 
 /*
    Helper function you will want all quarter
    Given a vector of shapes which has already been read from an obj file
    resize all vertices to the range [-1, 1]
  */
-void resize_obj(std::vector<tinyobj::shape_t> &shapes)
+void resize_obj(std::vector<tinyobj::shape_t> &shapes, int numThreads, bool forceScalar)
 {
-    float minX, minY, minZ;
-    float maxX, maxY, maxZ;
-    float scaleX, scaleY, scaleZ;
-    float shiftX, shiftY, shiftZ;
-    float epsilon = 0.001;
+    // the bounds and the rescale are both chunked over the threads and vectorized
+    applyNormalization(shapes, computeNormalization(shapes, numThreads, forceScalar), numThreads, forceScalar);
+}
+
+/*
+    Per-frame inputs of the shading modes: the mode, the lighting, the
+    varyings of every stream vertex (NUM_VARYINGS floats each) and the source
+    of every set up triangle. The depth and line modes leave both empty.
+*/
+struct FrameShading
+{
+    FrameShading() : mode(MODE_DEPTH) {}
 
-    minX = minY = minZ = 1.1754E+38F;
-    maxX = maxY = maxZ = -1.1754E+38F;
+    int mode;
+    ShadeParams params;
+    vector<float> varyings;
+    vector<TriangleSource> sources;
+};
 
-    // Go through all vertices to determine min and max of each dimension
-    for (size_t i = 0; i < shapes.size(); i++)
+/*
+    Varyings at the three corners of one set up triangle. Under a perspective
+    projection they are stored divided by w and interpolated together with
+    1 / w, which is divided out again per pixel. Corners that all share the
+    same w, as with the orthographic default, skip the divide.
+*/
+template <class Shader>
+struct CornerVaryings
+{
+    static const int SIZE = Shader::NUM_VARYINGS > 0 ? Shader::NUM_VARYINGS : 1;
+    float values[3][SIZE];
+    float invW[3];
+    bool perspective;
+
+    void load(const FrameShading &shading, unsigned int triIndex)
     {
-        for (size_t v = 0; v < shapes[i].mesh.positions.size() / 3; v++)
+        if (Shader::NUM_VARYINGS == 0)
+            return;
+        // clipped corners mix the varyings of the stream triangle's vertices
+        const TriangleSource &source = shading.sources[triIndex];
+        perspective = source.invW[0] != source.invW[1] || source.invW[0] != source.invW[2];
+        for (int k = 0; k < 3; k++)
         {
-            if (shapes[i].mesh.positions[3 * v + 0] < minX)
-                minX = shapes[i].mesh.positions[3 * v + 0];
-            if (shapes[i].mesh.positions[3 * v + 0] > maxX)
-                maxX = shapes[i].mesh.positions[3 * v + 0];
+            invW[k] = perspective ? source.invW[k] : 1.0f;
+            for (int c = 0; c < Shader::NUM_VARYINGS; c++)
+            {
+                values[k][c] = 0.0f;
+                for (int j = 0; j < 3; j++)
+                    values[k][c] += source.weights[k][j] * shading.varyings[source.vertices[j] * Shader::NUM_VARYINGS + c];
+                values[k][c] *= invW[k];
+            }
+        }
+    }
 
-            if (shapes[i].mesh.positions[3 * v + 1] < minY)
-                minY = shapes[i].mesh.positions[3 * v + 1];
-            if (shapes[i].mesh.positions[3 * v + 1] > maxY)
-                maxY = shapes[i].mesh.positions[3 * v + 1];
+    // weights are the screen space barycentric weights of the pixel
+    void interpolate(const float weights[3], float *out) const
+    {
+        for (int c = 0; c < Shader::NUM_VARYINGS; c++)
+            out[c] = weights[0] * values[0][c] + weights[1] * values[1][c] + weights[2] * values[2][c];
+        if (!perspective)
+            return;
+        float w = 1.0f / (weights[0] * invW[0] + weights[1] * invW[1] + weights[2] * invW[2]);
+        for (int c = 0; c < Shader::NUM_VARYINGS; c++)
+            out[c] *= w;
+    }
+};
 
-            if (shapes[i].mesh.positions[3 * v + 2] < minZ)
-                minZ = shapes[i].mesh.positions[3 * v + 2];
-            if (shapes[i].mesh.positions[3 * v + 2] > maxZ)
-                maxZ = shapes[i].mesh.positions[3 * v + 2];
-        }
+/*
+    Shade the pixels of a span that passed the depth test (bits of mask)
+    with Shader. Varyings are interpolated perspective correctly.
+*/
+template <class Shader>
+void shadePixels(const Triangle &triangle, const CornerVaryings<Shader> &corners, const ShadeParams &params, int x0,
+                 int y, int count, unsigned int mask, const float *zSpan, unsigned char *rgb)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (!(mask & (1u << i)))
+            continue;
+        float weights[3], varyings[CornerVaryings<Shader>::SIZE];
+        triangle.getBarycentrics(static_cast<float>(x0 + i), static_cast<float>(y), weights);
+        corners.interpolate(weights, varyings);
+        Shader::shade(varyings, zSpan[i], params, &rgb[3 * i]);
     }
+}
+
+/*
+    Fill a triangle with incrementally stepped edge functions and z-buffering.
+    The clipped bounding box is walked in BLOCK_SIZE x BLOCK_SIZE blocks and a
+    block is skipped when it lies completely outside one of the edges. Inside a
+    block the edge functions are evaluated once at the corner and then stepped
+    with adds, one per row. Each block row is handed to the pixel kernel and
+    its result written as one span; triangle setup clamps the bounding box to
+    the image, so spans are never checked against the image bounds here.
+    Blocks line up with the hierarchical z tiles, so a block is also skipped
+    when the triangle's nearest depth is behind the farthest depth stored there.
+    Raster is FloatRaster or FixedRaster (see RasterSetup.h). Shader is one of
+    the shaders of Shaders.h; the depth shader has no varyings and lets the
+    pixel kernel color, the others shade the pixels the kernel let through.
+    With a visibility buffer only depth and the triangle index are written
+    here; resolveVisibility colors the pixels afterwards.
+*/
+const int BLOCK_SIZE = KERNEL_WIDTH;
+static_assert(BLOCK_SIZE == HIZ_TILE_SIZE, "raster blocks must match hierarchical z tiles");
+
+template <class Raster, class Shader>
+void fillBlocks(shared_ptr<Image> outImage, const Triangle &triangle, const Raster &raster, unsigned int triIndex,
+                DepthBuffer &depth, VisibilityBuffer &vis, const FrameShading &shading, const Rect &clip,
+                CullStats &stats)
+{
+    if (!raster.isValid())
+        return;
+
+    int minX = max(raster.getMinX(), clip.minX);
+    int minY = max(raster.getMinY(), clip.minY);
+    int maxX = min(raster.getMaxX(), clip.maxX);
+    int maxY = min(raster.getMaxY(), clip.maxY);
+    if (minX > maxX || minY > maxY)
+        return;
+
+    // interpolated depth can round slightly past the nearest vertex, so keep a margin
+    float nearZ = max(triangle.getZ0(), max(triangle.getZ1(), triangle.getZ2())) + 1e-5f;
+    long long blocksTested = 0, blocksCulled = 0, pixelsTested = 0, depthPasses = 0;
+    // counting the passes is only worth it for --stats
+    const bool countPasses = g_stats.isEnabled();
+    const bool kernelShades = Shader::NUM_VARYINGS == 0;
+    const bool shadeNow = !vis.hasIds();
+    CornerVaryings<Shader> corners;
+    if (shadeNow && !kernelShades)
+        corners.load(shading, triIndex);
 
-    // From min and max compute necessary scale and shift for each dimension
-    float maxExtent, xExtent, yExtent, zExtent;
-    xExtent = maxX - minX;
-    yExtent = maxY - minY;
-    zExtent = maxZ - minZ;
-    if (xExtent >= yExtent && xExtent >= zExtent)
+    // blocks are aligned to the block grid so tiles split into whole blocks
+    for (int by = minY & ~(BLOCK_SIZE - 1); by <= maxY; by += BLOCK_SIZE)
     {
-        maxExtent = xExtent;
+        for (int bx = minX & ~(BLOCK_SIZE - 1); bx <= maxX; bx += BLOCK_SIZE)
+        {
+            typename Raster::Value w[3];
+            if (!raster.blockCorner(bx, by, w))
+                continue;
+
+            int tx = bx / HIZ_TILE_SIZE, ty = by / HIZ_TILE_SIZE;
+            blocksTested++;
+            if (g_useHiZ && nearZ < depth.getTileFar(tx, ty))
+            {
+                blocksCulled++;
+                continue;
+            }
+
+            int x0 = max(bx, minX), x1 = min(bx + BLOCK_SIZE - 1, maxX);
+            int y0 = max(by, minY), y1 = min(by + BLOCK_SIZE - 1, maxY);
+            raster.offset(w, x0 - bx, y0 - by);
+            unsigned char rgb[3 * KERNEL_WIDTH] = {};
+            unsigned char *color = shadeNow && kernelShades ? rgb : nullptr;
+            bool written = false;
+            for (int y = y0; y <= y1; y++)
+            {
+                float *zSpan = depth.getSpan(x0, y);
+                unsigned int mask = raster.shadeRow(w, x1 - x0 + 1, zSpan, color);
+                pixelsTested += x1 - x0 + 1;
+                if (mask)
+                {
+                    if (countPasses)
+                        depthPasses += bitset<32>(mask).count();
+                    if (shadeNow && !kernelShades)
+                        shadePixels(triangle, corners, shading.params, x0, y, x1 - x0 + 1, mask, zSpan, rgb);
+                    if (shadeNow)
+                        outImage->writeSpan(x0, y, x1 - x0 + 1, rgb, mask);
+                    if (vis.isEnabled())
+                        vis.writeSpan(x0, y, x1 - x0 + 1, triIndex, mask);
+                    written = true;
+                }
+                raster.stepRow(w);
+            }
+            if (written && g_useHiZ)
+            {
+                depth.updateTileFar(tx, ty);
+            }
+        }
     }
-    if (yExtent >= xExtent && yExtent >= zExtent)
+
+    if (blocksTested > 0)
     {
-        maxExtent = yExtent;
+        stats.blocksTested += blocksTested;
+        stats.blocksCulled += blocksCulled;
+        stats.pixelsTested += pixelsTested;
+        stats.depthPasses += depthPasses;
+        stats.triFlags[triIndex] |= blocksCulled < blocksTested ? (TRI_REACHED | TRI_DRAWN) : TRI_REACHED;
     }
-    if (zExtent >= xExtent && zExtent >= yExtent)
+}
+
+template <class Raster>
+void fillShaded(shared_ptr<Image> outImage, const Triangle &triangle, const Raster &raster, unsigned int triIndex,
+                DepthBuffer &depth, VisibilityBuffer &vis, const FrameShading &shading, const Rect &clip,
+                CullStats &stats)
+{
+    switch (shading.mode)
     {
-        maxExtent = zExtent;
+    case MODE_NORMALS:
+        fillBlocks<Raster, NormalShader>(outImage, triangle, raster, triIndex, depth, vis, shading, clip, stats);
+        break;
+    case MODE_GOURAUD:
+        fillBlocks<Raster, GouraudShader>(outImage, triangle, raster, triIndex, depth, vis, shading, clip, stats);
+        break;
+    case MODE_PHONG:
+        fillBlocks<Raster, PhongShader>(outImage, triangle, raster, triIndex, depth, vis, shading, clip, stats);
+        break;
+    default:
+        fillBlocks<Raster, DepthShader>(outImage, triangle, raster, triIndex, depth, vis, shading, clip, stats);
+        break;
     }
-    scaleX = 2.0 / maxExtent;
-    shiftX = minX + (xExtent / 2.0);
-    scaleY = 2.0 / maxExtent;
-    shiftY = minY + (yExtent / 2.0);
-    scaleZ = 2.0 / maxExtent;
-    shiftZ = minZ + (zExtent) / 2.0;
+}
 
-    // Go through all verticies shift and scale them
-    for (size_t i = 0; i < shapes.size(); i++)
+void drawFilled(shared_ptr<Image> outImage, const Triangle &triangle, unsigned int triIndex, DepthBuffer &depth,
+                VisibilityBuffer &vis, const FrameShading &shading, const Rect &clip, CullStats &stats)
+{
+    if (g_fixedPoint)
     {
-        for (size_t v = 0; v < shapes[i].mesh.positions.size() / 3; v++)
-        {
-            shapes[i].mesh.positions[3 * v + 0] = (shapes[i].mesh.positions[3 * v + 0] - shiftX) * scaleX;
-            assert(shapes[i].mesh.positions[3 * v + 0] >= -1.0 - epsilon);
-            assert(shapes[i].mesh.positions[3 * v + 0] <= 1.0 + epsilon);
-            shapes[i].mesh.positions[3 * v + 1] = (shapes[i].mesh.positions[3 * v + 1] - shiftY) * scaleY;
-            assert(shapes[i].mesh.positions[3 * v + 1] >= -1.0 - epsilon);
-            assert(shapes[i].mesh.positions[3 * v + 1] <= 1.0 + epsilon);
-            shapes[i].mesh.positions[3 * v + 2] = (shapes[i].mesh.positions[3 * v + 2] - shiftZ) * scaleZ;
-            assert(shapes[i].mesh.positions[3 * v + 2] >= -1.0 - epsilon);
-            assert(shapes[i].mesh.positions[3 * v + 2] <= 1.0 + epsilon);
-        }
+        fillShaded(outImage, triangle, FixedRaster(triangle, BLOCK_SIZE), triIndex, depth, vis, shading, clip, stats);
+    }
+    else
+    {
+        fillShaded(outImage, triangle, FloatRaster(triangle, g_shadeRow, BLOCK_SIZE), triIndex, depth, vis, shading,
+                   clip, stats);
     }
 }
 
 /*
-    Bresenham's line drawing algorithm with z-buffering
+    Bin every triangle into the screen tiles its bounding box overlaps
 */
-void drawLine(Vec3 v0, Vec3 v1, shared_ptr<Image> outImage, vector<float> &zBuffer)
+void binTriangles(const vector<Triangle> &triangles, TileGrid &grid)
 {
-    int x0 = static_cast<int>(v0.getX());
-    int y0 = static_cast<int>(v0.getY());
-    int x1 = static_cast<int>(v1.getX());
-    int y1 = static_cast<int>(v1.getY());
-    float z0 = v0.getZ();
-    float z1 = v1.getZ();
+    grid.clear();
+    for (size_t i = 0; i < triangles.size(); i++)
+    {
+        grid.binTriangle(static_cast<unsigned int>(i), triangles[i].getBBox());
+    }
+}
 
-    // Calculate differences and steps
-    int dx = abs(x1 - x0);
-    int dy = abs(y1 - y0);
-    // Determine the direction of the increment
-    int sx = (x0 < x1) ? 1 : -1;
-    int sy = (y0 < y1) ? 1 : -1;
-    int err = dx - dy;
+/*
+    Anti-aliased rendering of one tile. Depth and color are kept for every
+    sample, but only for the pixels of this tile, and resolved into the image
+    before the worker moves on, so the full size buffers stay one value per
+    pixel. Edge functions are evaluated at each sample position with the
+    usual top-left rule. With supersampling every covered sample that passes
+    the depth test is shaded; with multisampling the triangle is shaded once
+    per pixel, at its first covered sample, and that color goes to every
+    sample that passed. A pixel resolves to the average of its samples and
+    the depth buffer gets the nearest sample depth.
+*/
+template <class Shader>
+void drawTileSamples(shared_ptr<Image> outImage, const vector<Triangle> &triangles, const vector<unsigned int> &bin,
+                     DepthBuffer &depth, const FrameShading &shading, const Rect &clip, CullStats &stats)
+{
+    const SamplePattern &pattern = *getSamplePattern(g_samples);
+    const int n = pattern.count;
+    int tileW = clip.maxX - clip.minX + 1, tileH = clip.maxY - clip.minY + 1;
+    vector<float> sampleZ(size_t(tileW) * tileH * n, -numeric_limits<float>::infinity());
+    vector<unsigned char> sampleRGB(size_t(tileW) * tileH * n * 3, 0);
+    long long pixelsTested = 0, depthPasses = 0;
 
-    // Initialize length and step for interpolation
-    int length = max(dx, dy);
-    int step = 0;
-    float zMin = -1.0f, zMax = 1.0f;
-    while (true)
+    for (unsigned int triIndex : bin)
     {
-        // Interpolate z
-        float t = (length == 0) ? 0.0f : static_cast<float>(step) / length;
-        float z = z0 * (1.0f - t) + z1 * t;
+        const Triangle &triangle = triangles[triIndex];
+        if (!(triangle.getArea() > 0))
+            continue;
+        CornerVaryings<Shader> corners;
+        corners.load(shading, triIndex);
+
+        // samples reach half a pixel past the pixel they belong to
+        BBox bbox = triangle.getBBox();
+        int minX = max(static_cast<int>(ceil(bbox.minX - 0.5f)), clip.minX);
+        int minY = max(static_cast<int>(ceil(bbox.minY - 0.5f)), clip.minY);
+        int maxX = min(static_cast<int>(floor(bbox.maxX + 0.5f)), clip.maxX);
+        int maxY = min(static_cast<int>(floor(bbox.maxY + 0.5f)), clip.maxY);
+        if (minX <= maxX && minY <= maxY)
+            pixelsTested += static_cast<long long>(maxX - minX + 1) * (maxY - minY + 1);
 
-        int idx = y0 * g_width + x0;
-        if (z > zBuffer[idx])
+        const Edge *edges[3] = {&triangle.getEdge(0), &triangle.getEdge(1), &triangle.getEdge(2)};
+        float dz1 = (triangle.getZ1() - triangle.getZ0()) / triangle.getArea();
+        float dz2 = (triangle.getZ2() - triangle.getZ0()) / triangle.getArea();
+        // how far each sample moves each edge function away from the pixel's value
+        float offset[3][MAX_SAMPLES];
+        for (int e = 0; e < 3; e++)
+            for (int k = 0; k < n; k++)
+                offset[e][k] = edges[e]->a * pattern.dx[k] + edges[e]->b * pattern.dy[k];
+
+        for (int y = minY; y <= maxY; y++)
         {
-            zBuffer[idx] = z;
-            // map z to desired rgb values
-            unsigned char red = static_cast<unsigned char>((z - zMin) / (zMax - zMin) * 100.0f);
-            unsigned char green = static_cast<unsigned char>((z - zMin) / (zMax - zMin) * 200.0f);
-            unsigned char blue = static_cast<unsigned char>((z - zMin) / (zMax - zMin) * 200.0f);
-            outImage->setPixel(x0, y0, red, green, blue);
+            for (int x = minX; x <= maxX; x++)
+            {
+                float w[3], e[3][MAX_SAMPLES];
+                for (int i = 0; i < 3; i++)
+                    w[i] = edges[i]->a * (x - edges[i]->x0) + edges[i]->b * (y - edges[i]->y0);
+
+                size_t first = (size_t(y - clip.minY) * tileW + (x - clip.minX)) * n;
+                float *zSamples = &sampleZ[first];
+                unsigned char *rgbSamples = &sampleRGB[3 * first];
+                unsigned int mask = 0;
+                for (int k = 0; k < n; k++)
+                {
+                    bool inside = true;
+                    for (int i = 0; i < 3; i++)
+                    {
+                        e[i][k] = w[i] + offset[i][k];
+                        inside = inside && (e[i][k] > 0 || (e[i][k] == 0 && edges[i]->topLeft));
+                    }
+                    if (!inside)
+                        continue;
+                    float z = triangle.getZ0() + e[1][k] * dz1 + e[2][k] * dz2;
+                    if (z > zSamples[k])
+                    {
+                        zSamples[k] = z;
+                        mask |= 1u << k;
+                    }
+                }
+                if (!mask)
+                    continue;
+                depthPasses++;
+
+                unsigned char rgb[3];
+                for (int k = 0; k < n; k++)
+                {
+                    if (!(mask & (1u << k)))
+                        continue;
+                    // multisampling shades at the first sample only and reuses the color
+                    if (g_superSample || (mask & ((1u << k) - 1)) == 0)
+                    {
+                        float weights[3], varyings[CornerVaryings<Shader>::SIZE];
+                        triangle.getBarycentrics(x + pattern.dx[k], y + pattern.dy[k], weights);
+                        corners.interpolate(weights, varyings);
+                        Shader::shade(varyings, zSamples[k], shading.params, rgb);
+                    }
+                    copy(rgb, rgb + 3, &rgbSamples[3 * k]);
+                }
+            }
+        }
+    }
+
+    // resolve, BLOCK_SIZE pixels at a time so spans stay inside a tile column
+    for (int y = clip.minY; y <= clip.maxY; y++)
+    {
+        for (int x0 = clip.minX; x0 <= clip.maxX; x0 += BLOCK_SIZE)
+        {
+            int count = min(BLOCK_SIZE, clip.maxX - x0 + 1);
+            unsigned char rgb[3 * BLOCK_SIZE];
+            float *zSpan = depth.getSpan(x0, y);
+            for (int j = 0; j < count; j++)
+            {
+                size_t first = (size_t(y - clip.minY) * tileW + (x0 + j - clip.minX)) * n;
+                int sum[3] = {0, 0, 0};
+                float nearest = -numeric_limits<float>::infinity();
+                for (int k = 0; k < n; k++)
+                {
+                    for (int c = 0; c < 3; c++)
+                        sum[c] += sampleRGB[3 * (first + k) + c];
+                    nearest = max(nearest, sampleZ[first + k]);
+                }
+                for (int c = 0; c < 3; c++)
+                    rgb[3 * j + c] = static_cast<unsigned char>((sum[c] + n / 2) / n);
+                zSpan[j] = nearest;
+            }
+            outImage->writeSpan(x0, y, count, rgb);
         }
+    }
+    stats.pixelsTested += pixelsTested;
+    stats.depthPasses += depthPasses;
+}
 
-        // Check if reached the end point
-        if (x0 == x1 && y0 == y1)
-            break;
+void drawTileShaded(shared_ptr<Image> outImage, const vector<Triangle> &triangles, const vector<unsigned int> &bin,
+                    DepthBuffer &depth, const FrameShading &shading, const Rect &clip, CullStats &stats)
+{
+    switch (shading.mode)
+    {
+    case MODE_NORMALS:
+        drawTileSamples<NormalShader>(outImage, triangles, bin, depth, shading, clip, stats);
+        break;
+    case MODE_GOURAUD:
+        drawTileSamples<GouraudShader>(outImage, triangles, bin, depth, shading, clip, stats);
+        break;
+    case MODE_PHONG:
+        drawTileSamples<PhongShader>(outImage, triangles, bin, depth, shading, clip, stats);
+        break;
+    default:
+        drawTileSamples<DepthShader>(outImage, triangles, bin, depth, shading, clip, stats);
+        break;
+    }
+}
 
-        // Calculate error term
-        int err2 = 2 * err;
-        if (err2 > -dy)
+/*
+    Rasterize the binned tiles of tile rows [firstRow, endRow) in parallel.
+    Each tile owns its own part of the image and z-buffer, so the workers never
+    touch the same pixel and no locking is needed. Within a tile triangles are
+    drawn in their original order, which keeps the output identical to drawing
+    them one after another.
+*/
+void drawTiles(shared_ptr<Image> outImage, const vector<Triangle> &triangles, const TileGrid &grid, DepthBuffer &depth,
+               VisibilityBuffer &vis, const FrameShading &shading, int numThreads, CullStats &stats, int firstRow,
+               int endRow)
+{
+    int tilesX = grid.getTilesX();
+    parallelFor((endRow - firstRow) * tilesX, numThreads, [&](int i)
+    {
+        int tile = firstRow * tilesX + i;
+        Rect clip = grid.getTileRect(tile);
+        if (g_samples > 1)
         {
-            err -= dy;
-            x0 += sx;
+            drawTileShaded(outImage, triangles, grid.getBin(tile), depth, shading, clip, stats);
+            return;
         }
-        if (err2 < dx)
+        for (unsigned int triIndex : grid.getBin(tile))
         {
-            err += dx;
-            y0 += sy;
+            drawFilled(outImage, triangles[triIndex], triIndex, depth, vis, shading, clip, stats);
         }
-        step++;
-    }
+    });
 }
 
 /*
-    write out image (PNG) data, using the triangles bounding box
-    Depending on mode, either fill the triangle using z-buffering (mode 0)
-    or draw the triangle edges using Bresenham's line algorithm (mode 1)
+    Draw the binned edges of the wireframe mode for tile rows
+    [firstRow, endRow) in parallel, the same way as drawTiles. Edges are
+    clipped to the tile on their major axis, so a worker only steps over the
+    pixels of an edge that fall inside its tile.
 */
-void draw(shared_ptr<Image> outImage, Triangle triangle, vector<float> &zBuffer, int mode)
+void drawEdgeTiles(shared_ptr<Image> outImage, const vector<LineEdge> &edges, const TileGrid &grid, DepthBuffer &depth,
+                   int numThreads, CullStats &stats, int firstRow, int endRow)
 {
-    triangle.computeBBox();
+    int tilesX = grid.getTilesX();
+    parallelFor((endRow - firstRow) * tilesX, numThreads, [&](int i)
+    {
+        int tile = firstRow * tilesX + i;
+        Rect clip = grid.getTileRect(tile);
+        EdgeCounts counts = {0, 0};
+        for (unsigned int edgeIndex : grid.getBin(tile))
+        {
+            drawEdge(edges[edgeIndex], outImage, depth, clip, g_smoothLines, counts);
+        }
+        stats.pixelsTested += counts.pixelsTested;
+        stats.depthPasses += counts.depthPasses;
+    });
+}
 
-    // for every point in the bounding Box of the triangle
-    if (mode == 0)
+/*
+    Shading pass of the visibility buffer: every pixel of tile rows
+    [firstRow, endRow) that a triangle covers is shaded exactly once, from the
+    barycentric weights of its triangle at the pixel. Tiles are shaded in
+    parallel and each writes its rows as spans.
+*/
+template <class Shader>
+void resolveVisibility(shared_ptr<Image> outImage, const vector<Triangle> &triangles, const TileGrid &grid,
+                       const VisibilityBuffer &vis, const FrameShading &shading, int numThreads, int firstRow,
+                       int endRow)
+{
+    int tilesX = grid.getTilesX();
+    parallelFor((endRow - firstRow) * tilesX, numThreads, [&](int i)
     {
-        float xa = triangle.getX0();
-        float ya = triangle.getY0();
-        float xb = triangle.getX1();
-        float yb = triangle.getY1();
-        float xc = triangle.getX2();
-        float yc = triangle.getY2();
-        float zMin = -1.0f, zMax = 1.0f;
-        for (int y = triangle.getBBox().minY; y <= triangle.getBBox().maxY; y++)
+        Rect rect = grid.getTileRect(firstRow * tilesX + i);
+        unsigned char rgb[3 * BLOCK_SIZE];
+        for (int y = rect.minY; y <= rect.maxY; y++)
         {
-            for (int x = triangle.getBBox().minX; x <= triangle.getBBox().maxX; x++)
+            for (int x0 = rect.minX; x0 <= rect.maxX; x0 += BLOCK_SIZE)
             {
-                float beta = ((xa - xc) * (y - yc) - (x - xc) * (ya - yc)) /
-                             ((xb - xa) * (yc - ya) - (xc - xa) * (yb - ya));
-                float gamma = ((xb - xa) * (y - ya) - (x - xa) * (yb - ya)) /
-                              ((xb - xa) * (yc - ya) - (xc - xa) * (yb - ya));
-                float alpha = 1.0f - beta - gamma;
-                if (0 <= alpha && alpha <= 1 && 0 <= beta && beta <= 1 && 0 <= gamma && gamma <= 1)
+                int count = min(BLOCK_SIZE, rect.maxX - x0 + 1);
+                for (int j = 0; j < count; j++)
                 {
-                    // update rasterization if the z value is larger
-                    float z = alpha * triangle.getZ0() + beta * triangle.getZ1() + gamma * triangle.getZ2();
-                    int idx = y * g_width + x;
-                    if (z > zBuffer[idx])
+                    unsigned int id = vis.getId(x0 + j, y);
+                    if (id == NO_TRIANGLE)
                     {
-                        zBuffer[idx] = z;
-                        // map z to desired rgb values
-                        unsigned char red = static_cast<unsigned char>((z - zMin) / (zMax - zMin) * 100.0f);
-                        unsigned char green = static_cast<unsigned char>((z - zMin) / (zMax - zMin) * 200.0f);
-                        unsigned char blue = static_cast<unsigned char>((z - zMin) / (zMax - zMin) * 200.0f);
-                        outImage->setPixel(x, y, red, green, blue);
+                        rgb[3 * j] = rgb[3 * j + 1] = rgb[3 * j + 2] = 0;
+                        continue;
                     }
+                    const Triangle &triangle = triangles[id];
+                    float weights[3], varyings[CornerVaryings<Shader>::SIZE];
+                    triangle.getBarycentrics(static_cast<float>(x0 + j), static_cast<float>(y), weights);
+                    float z = weights[0] * triangle.getZ0() + weights[1] * triangle.getZ1() + weights[2] * triangle.getZ2();
+                    CornerVaryings<Shader> corners;
+                    corners.load(shading, id);
+                    corners.interpolate(weights, varyings);
+                    Shader::shade(varyings, z, shading.params, &rgb[3 * j]);
                 }
+                outImage->writeSpan(x0, y, count, rgb);
             }
         }
+    });
+}
+
+void resolveShaded(shared_ptr<Image> outImage, const vector<Triangle> &triangles, const TileGrid &grid,
+                   const VisibilityBuffer &vis, const FrameShading &shading, int numThreads, int firstRow, int endRow)
+{
+    switch (shading.mode)
+    {
+    case MODE_NORMALS:
+        resolveVisibility<NormalShader>(outImage, triangles, grid, vis, shading, numThreads, firstRow, endRow);
+        break;
+    case MODE_GOURAUD:
+        resolveVisibility<GouraudShader>(outImage, triangles, grid, vis, shading, numThreads, firstRow, endRow);
+        break;
+    case MODE_PHONG:
+        resolveVisibility<PhongShader>(outImage, triangles, grid, vis, shading, numThreads, firstRow, endRow);
+        break;
+    default:
+        resolveVisibility<DepthShader>(outImage, triangles, grid, vis, shading, numThreads, firstRow, endRow);
+        break;
+    }
+}
+
+/* Per-vertex varyings of every stream vertex, from its normal */
+template <class Shader>
+void computeVaryings(const TriangleStream &stream, FrameShading &shading)
+{
+    shading.varyings.resize(stream.getVertexCount() * Shader::NUM_VARYINGS);
+    for (size_t v = 0; v < stream.getVertexCount(); v++)
+    {
+        float normal[3] = {stream.nx[v], stream.ny[v], stream.nz[v]};
+        Shader::vertex(normal, shading.params, &shading.varyings[v * Shader::NUM_VARYINGS]);
+    }
+}
+
+/*
+    Buffers that are allocated once and reused for every frame
+    The depth buffer covers depthRows rows, the whole image or one band.
+    The cache counters are created here, before any worker thread exists, so
+    they also count the tile workers.
+*/
+struct FrameBuffers
+{
+    FrameBuffers(int width, int height, int depthRows, BufferLayout layout, bool visibility, bool overdraw) :
+        grid(width, height), depth(width, depthRows, layout), vis(width, depthRows, layout, visibility, overdraw) {}
+
+    PostTransformBuffer verts;
+    vector<Triangle> triangles;
+    // the unique edges of the triangles, for the wireframe mode
+    vector<LineEdge> edges;
+    TileGrid grid;
+    DepthBuffer depth;
+    VisibilityBuffer vis;
+    FrameShading shading;
+    CullStats stats;
+    CacheCounters counters;
+};
+
+/*
+    Everything before rasterization: transform the vertices, compute the
+    varyings of the shading mode, set up and bin the triangles and reset the
+    culling counters
+*/
+void prepareFrame(const TriangleStream &stream, const Mat4 &mvp, const SetupOptions &setup, int mode, int numThreads,
+                  bool forceScalar, FrameBuffers &buffers, SetupStats &setupStats)
+{
+    // transform every vertex once, then set up each triangle from the results
+    {
+        ScopedTimer timer(g_stats, "vertex");
+        transformVertices(stream, mvp, setup.viewport, buffers.verts, numThreads, forceScalar);
+    }
+
+    FrameShading &shading = buffers.shading;
+    shading.mode = mode;
+    shading.sources.clear();
+    if (modeUsesNormals(mode))
+    {
+        ScopedTimer timer(g_stats, "varyings");
+        shading.params = makeShadeParams(mvp);
+        if (mode == MODE_NORMALS)
+            computeVaryings<NormalShader>(stream, shading);
+        else if (mode == MODE_GOURAUD)
+            computeVaryings<GouraudShader>(stream, shading);
+        else
+            computeVaryings<PhongShader>(stream, shading);
+    }
+
+    buffers.triangles.clear();
+    setupStats = SetupStats();
+    vector<TriangleSource> *sources = modeUsesNormals(mode) ? &shading.sources : nullptr;
+    {
+        ScopedTimer timer(g_stats, "setup");
+        for (size_t i = 0; i < stream.getTriangleCount(); i++)
+        {
+            const unsigned int *index = &stream.indices[3 * i];
+            setupTriangle(buffers.verts, index[0], index[1], index[2], setup, buffers.triangles, setupStats, sources);
+        }
+    }
+
+    // the wireframe mode bins its edges instead of the triangles
+    ScopedTimer timer(g_stats, "bin");
+    if (mode == MODE_LINES)
+    {
+        extractEdges(buffers.triangles, buffers.edges);
+        binEdges(buffers.edges, buffers.grid);
+    }
+    else
+    {
+        binTriangles(buffers.triangles, buffers.grid);
+    }
+    buffers.stats.reset(buffers.triangles.size());
+}
+
+/* Seconds spent in the passes of a frame, added up over bands */
+struct FrameTimes
+{
+    FrameTimes() : raster(0.0), shade(0.0) {}
+    double raster, shade;
+};
+
+/*
+    Rasterize tile rows [firstRow, endRow) into the cleared buffers and, with
+    a visibility buffer, shade them
+*/
+void drawRows(shared_ptr<Image> image, FrameBuffers &buffers, int numThreads, int firstRow, int endRow,
+              FrameTimes &times)
+{
+    auto start = chrono::steady_clock::now();
+    buffers.counters.start();
+    if (buffers.shading.mode == MODE_LINES)
+        drawEdgeTiles(image, buffers.edges, buffers.grid, buffers.depth, numThreads, buffers.stats, firstRow, endRow);
+    else
+        drawTiles(image, buffers.triangles, buffers.grid, buffers.depth, buffers.vis, buffers.shading, numThreads,
+                  buffers.stats, firstRow, endRow);
+    buffers.counters.stop();
+    auto rasterEnd = chrono::steady_clock::now();
+    times.raster += chrono::duration<double>(rasterEnd - start).count();
+    g_stats.addTime("raster", chrono::duration<double>(rasterEnd - start).count());
+    if (g_stats.isEnabled())
+    {
+        // pixels something was drawn on, the depth buffer only holds these rows in band mode
+        long long covered = 0;
+        for (int y = firstRow * TILE_SIZE; y < min(endRow * TILE_SIZE, g_height); y++)
+            for (int x = 0; x < g_width; x++)
+                covered += buffers.depth.at(x, y) > -numeric_limits<float>::infinity();
+        g_stats.addCount("pixels_covered", static_cast<double>(covered));
+    }
+    if (!buffers.vis.hasIds())
+        return;
+
+    resolveShaded(image, buffers.triangles, buffers.grid, buffers.vis, buffers.shading, numThreads, firstRow, endRow);
+    times.shade += chrono::duration<double>(chrono::steady_clock::now() - rasterEnd).count();
+    g_stats.addTime("shade", chrono::duration<double>(chrono::steady_clock::now() - rasterEnd).count());
+}
+
+/* Triangles that reached the depth test but were entirely rejected by hierarchical z */
+long long countHiZCulled(const CullStats &stats)
+{
+    long long culled = 0;
+    for (size_t i = 0; i < stats.numTriangles; i++)
+    {
+        if (stats.triFlags[i].load() == TRI_REACHED)
+            culled++;
+    }
+    return culled;
+}
+
+/* Add the counters of a finished frame to the --stats totals */
+void recordFrameStats(const SetupStats &setupStats, const FrameBuffers &buffers)
+{
+    if (!g_stats.isEnabled())
+        return;
+    g_stats.addCount("frames", 1);
+    g_stats.addCount("triangles_in", static_cast<double>(setupStats.trianglesIn));
+    g_stats.addCount("triangles_culled", static_cast<double>(setupStats.culled));
+    g_stats.addCount("triangles_outside", static_cast<double>(setupStats.outside));
+    g_stats.addCount("triangles_clipped", static_cast<double>(setupStats.clipped));
+    g_stats.addCount("triangles_rasterized", static_cast<double>(buffers.triangles.size()));
+    g_stats.addCount("triangles_hiz_culled", static_cast<double>(countHiZCulled(buffers.stats)));
+    g_stats.addCount("edges_drawn", static_cast<double>(buffers.edges.size()));
+    g_stats.addCount("blocks_tested", static_cast<double>(buffers.stats.blocksTested));
+    g_stats.addCount("blocks_hiz_culled", static_cast<double>(buffers.stats.blocksCulled));
+    g_stats.addCount("pixels_tested", static_cast<double>(buffers.stats.pixelsTested));
+    g_stats.addCount("depth_passes", static_cast<double>(buffers.stats.depthPasses));
+}
+
+void printFrameStats(const SetupStats &setupStats, FrameBuffers &buffers, BufferLayout layout, const FrameTimes &times)
+{
+    // compare runs with and without --tiled to see what the layout changes
+    cout << "Raster (" << (layout == LAYOUT_TILED ? "tiled" : "row-major") << " layout): " << times.raster * 1000.0
+         << " ms";
+    if (buffers.counters.isAvailable())
+    {
+        for (int event = 0; event < CACHE_EVENT_COUNT; event++)
+            cout << ", " << getCacheEventName(static_cast<CacheEvent>(event)) << " "
+                 << buffers.counters.getCount(static_cast<CacheEvent>(event));
+        cout << endl;
     }
     else
     {
-        drawLine(triangle.getV0(), triangle.getV1(), outImage, zBuffer);
-        drawLine(triangle.getV1(), triangle.getV2(), outImage, zBuffer);
-        drawLine(triangle.getV2(), triangle.getV0(), outImage, zBuffer);
+        cout << ", cache counters not available" << endl;
+    }
+    if (buffers.vis.hasIds())
+        cout << "Visibility shading: " << times.shade * 1000.0 << " ms" << endl;
+
+    cout << "Triangle setup culled " << setupStats.culled << ", dropped " << setupStats.outside << " outside and clipped "
+         << setupStats.clipped << " triangles" << endl;
+    if (buffers.shading.mode == MODE_LINES)
+    {
+        cout << "Wireframe drew " << buffers.edges.size() << " unique edges of " << buffers.triangles.size()
+             << " triangles" << endl;
+    }
+    else
+    {
+        cout << "Hierarchical z culled " << countHiZCulled(buffers.stats) << " triangles and " << buffers.stats.blocksCulled << " of "
+             << buffers.stats.blocksTested << " blocks" << endl;
+    }
+}
+
+/*
+    Render one view of the mesh into image, which must already be cleared
+*/
+void renderFrame(shared_ptr<Image> image, const TriangleStream &stream, const Mat4 &mvp, const SetupOptions &setup,
+                 int mode, int numThreads, bool forceScalar, FrameBuffers &buffers, bool verbose)
+{
+    SetupStats setupStats;
+    prepareFrame(stream, mvp, setup, mode, numThreads, forceScalar, buffers, setupStats);
+
+    {
+        ScopedTimer timer(g_stats, "clear");
+        buffers.depth.clear();
+        buffers.vis.clear();
+    }
+    FrameTimes times;
+    drawRows(image, buffers, numThreads, 0, buffers.grid.getTilesY(), times);
+    recordFrameStats(setupStats, buffers);
+    if (verbose)
+        printFrameStats(setupStats, buffers, image->getLayout(), times);
+}
+
+/*
+    Render an image too large to keep in memory. The triangles are set up and
+    binned once for the whole image, then the tile rows are drawn bandRows
+    rows at a time into one band sized color and depth buffer, from the top
+    of the image down. Every finished band is handed to the encoder straight
+    away, so memory grows with the width and band height only.
+*/
+bool renderBands(const string &imgName, const TriangleStream &stream, const Mat4 &mvp, const SetupOptions &setup,
+                 int mode, int numThreads, bool forceScalar, int bandRows, BufferLayout layout, bool visibility)
+{
+    FrameBuffers buffers(g_width, g_height, bandRows, layout, visibility, false);
+    shared_ptr<Image> band = make_shared<Image>(g_width, bandRows, false, layout);
+    vector<unsigned char> rows(size_t(g_width) * 3 * bandRows);
+    RowStreamWriter writer(imgName, g_width, g_height, numThreads);
+    if (!writer.isOpen())
+    {
+        cout << "Couldn't write to " << imgName << endl;
+        return false;
+    }
+
+    SetupStats setupStats;
+    prepareFrame(stream, mvp, setup, mode, numThreads, forceScalar, buffers, setupStats);
+
+    FrameTimes times;
+    auto start = chrono::steady_clock::now();
+    int numBands = (g_height + bandRows - 1) / bandRows;
+    for (int b = numBands - 1; b >= 0; b--)
+    {
+        int y0 = b * bandRows, y1 = min(y0 + bandRows, g_height);
+        {
+            ScopedTimer timer(g_stats, "clear");
+            band->setOriginY(y0);
+            band->clear();
+            buffers.depth.setOriginY(y0);
+            buffers.depth.clear();
+            buffers.vis.setOriginY(y0);
+            buffers.vis.clear();
+        }
+        drawRows(band, buffers, numThreads, y0 / TILE_SIZE, (y1 + TILE_SIZE - 1) / TILE_SIZE, times);
+
+        // the encoder wants the top row first
+        ScopedTimer timer(g_stats, "encode");
+        for (int y = y1 - 1; y >= y0; y--)
+            band->readRow(y, &rows[size_t(y1 - 1 - y) * g_width * 3]);
+        if (!writer.writeRows(&rows[0], y1 - y0))
+        {
+            cout << "Couldn't write to " << imgName << endl;
+            return false;
+        }
+    }
+    size_t bytes;
+    {
+        ScopedTimer timer(g_stats, "encode");
+        bytes = writer.finish();
+    }
+    recordFrameStats(setupStats, buffers);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (!bytes)
+    {
+        cout << "Couldn't write to " << imgName << endl;
+        return false;
+    }
+
+    printFrameStats(setupStats, buffers, layout, times);
+    double megabytes = double(g_width) * g_height * 3 / 1e6;
+    cout << "Wrote to " << imgName << " in " << numBands << " bands of " << bandRows << " rows ("
+         << getFormatName(formatFromFileName(imgName)) << ", " << bytes / 1e6 << " MB, " << megabytes / seconds
+         << " MB/s)" << endl;
+    return true;
+}
+
+/* image.png -> image_0007.png */
+string frameFileName(const string &imgName, int frame)
+{
+    char number[16];
+    snprintf(number, sizeof(number), "_%04d", frame);
+    size_t dot = imgName.find_last_of('.');
+    size_t slash = imgName.find_last_of('/');
+    if (dot == string::npos || (slash != string::npos && dot < slash))
+        return imgName + number;
+    return imgName.substr(0, dot) + number + imgName.substr(dot);
+}
+
+/* One row-major matrix per line, # starts a comment */
+bool loadViews(const string &filename, vector<Mat4> &views)
+{
+    ifstream file(filename);
+    if (!file)
+        return false;
+    string line;
+    while (getline(file, line))
+    {
+        line = line.substr(0, line.find('#'));
+        if (line.find_first_not_of(" \t\r") == string::npos)
+            continue;
+        Mat4 view;
+        if (!parseMatrix(line, view))
+            return false;
+        views.push_back(view);
     }
+    return !views.empty();
+}
+
+/*
+    Finish the --stats report: the total time, overdraw as depth test passes
+    per covered pixel, and the JSON file
+*/
+void writeStats(const string &statsName, chrono::steady_clock::time_point start)
+{
+    if (!g_stats.isEnabled())
+        return;
+    g_stats.addTime("total", chrono::duration<double>(chrono::steady_clock::now() - start).count());
+    double covered = g_stats.getCount("pixels_covered");
+    g_stats.addCount("overdraw", covered > 0 ? g_stats.getCount("depth_passes") / covered : 0.0);
+    if (g_stats.writeJson(statsName))
+        cout << "Wrote stats to " << statsName << endl;
+    else
+        cout << "Couldn't write to " << statsName << endl;
 }
 
 int main(int argc, char **argv)
 {
-    if (argc != 6)
+    auto runStart = chrono::steady_clock::now();
+    if (argc < 6)
     {
-        cout << "Usage: " << argv[0] << " <meshfile> <imagefile> <width> <height> <mode>" << endl;
+        cout << "Usage: " << argv[0] << " <meshfile> <imagefile> <width> <height> <mode> [--threads N] [--scalar] [--no-hiz] [--fixed]"
+             << " [--cull <none|cw|ccw>] [--near z] [--camera file] [--mvp m00,m01,...,m33]"
+             << " [--frames N | --views file] [--depth file.pfm] [--tiled] [--band rows] [--visibility]"
+             << " [--overdraw file] [--ssaa N | --msaa N] [--smooth-lines] [--fold-resize]"
+             << " [--stats file.json]" << endl;
         return 0;
     }
 
@@ -229,26 +956,226 @@ int main(int argc, char **argv)
     g_height = stoi(argv[4]);
     int mode = stoi(argv[5]);
 
-    if (mode != 0 && mode != 1)
+    if (mode < 0 || mode >= MODE_COUNT)
     {
         cout << "Invalid mode: " << mode << endl;
         return 0;
     }
 
-    // create an image
-    auto image = make_shared<Image>(g_width, g_height);
+    // optional flags
+    int numThreads = max(1, static_cast<int>(thread::hardware_concurrency()));
+    bool forceScalar = false;
+    // apply the resize to [-1, 1] in the vertex stage instead of to the positions
+    bool foldResize = false;
+    SetupOptions setup;
+    setup.width = g_width;
+    setup.height = g_height;
+    setup.cull = CULL_NONE;
+    setup.zNear = numeric_limits<float>::infinity();
+    bool nearGiven = false;
+    Camera camera;
+    bool useCamera = false;
+    int numFrames = 1;
+    vector<Mat4> views;
+    string depthName;
+    BufferLayout layout = LAYOUT_ROWS;
+    int bandRows = 0;
+    bool visibility = false;
+    string overdrawName;
+    string statsName;
+    for (int i = 6; i < argc; i++)
+    {
+        string arg(argv[i]);
+        if (arg == "--threads" && i + 1 < argc)
+        {
+            numThreads = stoi(argv[++i]);
+        }
+        else if (arg == "--scalar")
+        {
+            forceScalar = true;
+        }
+        else if (arg == "--no-hiz")
+        {
+            g_useHiZ = false;
+        }
+        else if (arg == "--fixed")
+        {
+            g_fixedPoint = true;
+        }
+        else if (arg == "--fold-resize")
+        {
+            foldResize = true;
+        }
+        else if (arg == "--smooth-lines")
+        {
+            g_smoothLines = true;
+        }
+        else if (arg == "--cull" && i + 1 < argc)
+        {
+            string winding(argv[++i]);
+            if (winding == "none")
+                setup.cull = CULL_NONE;
+            else if (winding == "cw")
+                setup.cull = CULL_CW;
+            else if (winding == "ccw")
+                setup.cull = CULL_CCW;
+            else
+            {
+                cout << "Invalid cull winding: " << winding << endl;
+                return 0;
+            }
+        }
+        else if (arg == "--near" && i + 1 < argc)
+        {
+            setup.zNear = stof(argv[++i]);
+            nearGiven = true;
+        }
+        else if (arg == "--camera" && i + 1 < argc)
+        {
+            string err;
+            if (!loadCamera(argv[++i], camera, err))
+            {
+                cout << err << endl;
+                return 0;
+            }
+            useCamera = true;
+        }
+        else if (arg == "--mvp" && i + 1 < argc)
+        {
+            if (!parseMatrix(argv[++i], camera.matrix))
+            {
+                cout << "Invalid matrix: " << argv[i] << endl;
+                return 0;
+            }
+            camera.hasMatrix = true;
+            useCamera = true;
+        }
+        else if (arg == "--frames" && i + 1 < argc)
+        {
+            numFrames = stoi(argv[++i]);
+            if (numFrames < 1)
+            {
+                cout << "Invalid frame count: " << numFrames << endl;
+                return 0;
+            }
+        }
+        else if (arg == "--depth" && i + 1 < argc)
+        {
+            depthName = argv[++i];
+            if (formatFromFileName(depthName) != FORMAT_PFM)
+            {
+                cout << "Depth can only be written as .pfm: " << depthName << endl;
+                return 0;
+            }
+        }
+        else if (arg == "--band" && i + 1 < argc)
+        {
+            bandRows = stoi(argv[++i]);
+            if (bandRows < TILE_SIZE || bandRows % TILE_SIZE != 0)
+            {
+                cout << "Band height must be a multiple of " << TILE_SIZE << ": " << bandRows << endl;
+                return 0;
+            }
+        }
+        else if ((arg == "--ssaa" || arg == "--msaa") && i + 1 < argc)
+        {
+            g_samples = stoi(argv[++i]);
+            g_superSample = arg == "--ssaa";
+            if (!getSamplePattern(g_samples))
+            {
+                cout << "Samples per pixel must be 2, 4 or 8: " << g_samples << endl;
+                return 0;
+            }
+        }
+        else if (arg == "--visibility")
+        {
+            visibility = true;
+        }
+        else if (arg == "--overdraw" && i + 1 < argc)
+        {
+            overdrawName = argv[++i];
+        }
+        else if (arg == "--stats" && i + 1 < argc)
+        {
+            statsName = argv[++i];
+            g_stats.enable();
+        }
+        else if (arg == "--tiled")
+        {
+            layout = LAYOUT_TILED;
+        }
+        else if (arg == "--views" && i + 1 < argc)
+        {
+            if (!loadViews(argv[++i], views))
+            {
+                cout << "Cannot read views from " << argv[i] << endl;
+                return 0;
+            }
+        }
+        else
+        {
+            cout << "Invalid option: " << arg << endl;
+            return 0;
+        }
+    }
+    if (formatFromFileName(imgName) == FORMAT_PFM)
+    {
+        cout << "Color images cannot be written as .pfm, use --depth for the depth buffer" << endl;
+        return 0;
+    }
+    if ((visibility || !overdrawName.empty()) && mode == MODE_LINES)
+    {
+        cout << "--visibility and --overdraw need a filled mode" << endl;
+        return 0;
+    }
+    if (g_smoothLines && mode != MODE_LINES)
+    {
+        cout << "--smooth-lines only applies to mode 1" << endl;
+        return 0;
+    }
+    if (g_samples > 1 && (mode == MODE_LINES || visibility || !overdrawName.empty() || g_fixedPoint))
+    {
+        cout << "--ssaa and --msaa need a filled mode and cannot be combined with --visibility, --overdraw or --fixed"
+             << endl;
+        return 0;
+    }
+    if (bandRows > 0)
+    {
+        if (!RowStreamWriter::canStream(formatFromFileName(imgName)))
+        {
+            cout << "Only .png and .ppm images can be written in bands" << endl;
+            return 0;
+        }
+        if (numFrames > 1 || !views.empty() || !depthName.empty() || !overdrawName.empty())
+        {
+            cout << "--band renders a single color image, without --frames, --views, --depth or --overdraw" << endl;
+            return 0;
+        }
+    }
+    if (numThreads < 1)
+    {
+        cout << "Invalid thread count: " << numThreads << endl;
+        return 0;
+    }
 
-    // triangle buffer
-    vector<unsigned int> triBuf;
-    // position buffer
-    vector<float> posBuf;
+    g_shadeRow = selectShadeRow(forceScalar);
+    cout << "Pixel kernel: " << (g_fixedPoint ? "fixed" : getShadeRowName(g_shadeRow)) << endl;
+
+    // all shapes of the mesh as one triangle list
+    TriangleStream stream;
     // Some obj files contain material information.
     // We'll ignore them for this assignment.
     vector<tinyobj::shape_t> shapes;          // geometry
     vector<tinyobj::material_t> objMaterials; // material
     string errStr;
+    // the resize when it is folded into the matrix, otherwise identity
+    Mat4 model;
 
-    bool rc = tinyobj::LoadObj(shapes, objMaterials, errStr, meshName.c_str());
+    bool rc;
+    {
+        ScopedTimer timer(g_stats, "load");
+        rc = tinyobj::LoadObj(shapes, objMaterials, errStr, meshName.c_str());
+    }
     /* error checking on read */
     if (!rc)
     {
@@ -257,26 +1184,109 @@ int main(int argc, char **argv)
     else
     {
         // keep this code to resize your object to be within -1 -> 1
-        resize_obj(shapes);
-        posBuf = shapes[0].mesh.positions;
-        triBuf = shapes[0].mesh.indices;
+        auto start = chrono::steady_clock::now();
+        if (foldResize)
+            model = normalizationMatrix(computeNormalization(shapes, numThreads, forceScalar));
+        else
+            resize_obj(shapes, numThreads, forceScalar);
+        double resizeSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        g_stats.addTime("resize", resizeSeconds);
+        cout << "Resize (" << (foldResize ? "folded into the matrix" : "in place") << "): " << resizeSeconds * 1000.0
+             << " ms" << endl;
+        ScopedTimer timer(g_stats, "flatten");
+        flattenShapes(shapes, stream, modeUsesNormals(mode));
     }
-    cout << "Number of vertices: " << posBuf.size() / 3 << endl;
-    cout << "Number of triangles: " << triBuf.size() / 3 << endl;
+    cout << "Number of shapes: " << shapes.size() << endl;
+    cout << "Number of vertices: " << stream.getVertexCount() << endl;
+    cout << "Number of triangles: " << stream.getTriangleCount() << endl;
+
+    // without a camera the resized mesh is drawn orthographically, filling the
+    // shorter side of the image; depth is -z / w so the z axis is flipped
+    Mat4 mvp = Mat4::scale(1.0f, 1.0f, -1.0f);
+    Viewport &viewport = setup.viewport;
+    viewport.translationX = (g_width - 1) * 0.5f;
+    viewport.translationY = (g_height - 1) * 0.5f;
+    viewport.scaleX = viewport.scaleY = (min(g_width, g_height) - 1) * 0.5f;
+    if (useCamera)
+        mvp = camera.getMVP(static_cast<float>(g_width) / g_height);
+    // the matrices of a views file are full matrices like --mvp
+    if (useCamera || !views.empty())
+    {
+        viewport.scaleX = (g_width - 1) * 0.5f;
+        viewport.scaleY = (g_height - 1) * 0.5f;
+        // clip at the near plane of the projection
+        if (!nearGiven)
+            setup.zNear = 1.0f;
+    }
+
+    cout << "Vertex kernel: " << getVertexKernelName(forceScalar) << endl;
 
-    // iterate through each triangle and rasterize it
-    float translationX = (g_width - 1) * 0.5f;
-    float translationY = (g_height - 1) * 0.5f;
-    float scale = (min(g_width, g_height) - 1) * 0.5f;
-    std::vector<float> zBuffer(g_width * g_height, -std::numeric_limits<float>::infinity());
-    for (size_t i = 0; i < triBuf.size(); i += 3)
+    g_stats.setInfo("mesh", meshName);
+    g_stats.setInfo("image", imgName);
+    g_stats.setInfo("width", g_width);
+    g_stats.setInfo("height", g_height);
+    g_stats.setInfo("mode", mode);
+    g_stats.setInfo("threads", numThreads);
+    g_stats.setInfo("layout", layout == LAYOUT_TILED ? "tiled" : "row-major");
+    g_stats.setInfo("pixel_kernel", g_fixedPoint ? "fixed" : getShadeRowName(g_shadeRow));
+    g_stats.setInfo("vertex_kernel", getVertexKernelName(forceScalar));
+    g_stats.setInfo("vertices", static_cast<double>(stream.getVertexCount()));
+    g_stats.setInfo("triangles", static_cast<double>(stream.getTriangleCount()));
+
+    if (bandRows > 0)
     {
-        Triangle triangle = Triangle(posBuf, triBuf, i, translationX, translationY, scale);
-        draw(image, triangle, zBuffer, mode);
+        renderBands(imgName, stream, mvp * model, setup, mode, numThreads, forceScalar, bandRows, layout, visibility);
+        writeStats(statsName, runStart);
+        return 0;
     }
 
-    // write out the image
-    image->writeToFile(imgName);
+    // a single frame, a turntable of numFrames frames around the y axis, or
+    // one frame per matrix of the views file
+    if (views.empty())
+    {
+        for (int frame = 0; frame < numFrames; frame++)
+        {
+            float angle = static_cast<float>(2.0 * pi * frame / numFrames);
+            views.push_back(numFrames == 1 ? mvp : mvp * Mat4::rotateY(angle));
+        }
+    }
+    for (Mat4 &view : views)
+        view = view * model;
+    bool batch = views.size() > 1;
+
+    // while frame k is written out on its own thread, frame k + 1 is drawn
+    // into the other image
+    shared_ptr<Image> images[2] = {make_shared<Image>(g_width, g_height, false, layout),
+                                   make_shared<Image>(g_width, g_height, false, layout)};
+    FrameBuffers buffers(g_width, g_height, g_height, layout, visibility, !overdrawName.empty());
+    thread writer;
+    for (size_t frame = 0; frame < views.size(); frame++)
+    {
+        shared_ptr<Image> image = images[frame % 2];
+        image->clear();
+        renderFrame(image, stream, views[frame], setup, mode, numThreads, forceScalar, buffers, !batch);
+
+        {
+            ScopedTimer timer(g_stats, "extra_files");
+            if (!depthName.empty())
+                buffers.depth.writeToFile(batch ? frameFileName(depthName, static_cast<int>(frame)) : depthName);
+            if (!overdrawName.empty())
+                buffers.vis.writeOverdraw(batch ? frameFileName(overdrawName, static_cast<int>(frame)) : overdrawName,
+                                          numThreads);
+        }
+
+        string name = batch ? frameFileName(imgName, static_cast<int>(frame)) : imgName;
+        if (writer.joinable())
+            writer.join();
+        writer = thread([image, name, numThreads]()
+        {
+            ScopedTimer timer(g_stats, "encode");
+            image->writeToFile(name, numThreads);
+        });
+    }
+    if (writer.joinable())
+        writer.join();
 
+    writeStats(statsName, runStart);
     return 0;
 }
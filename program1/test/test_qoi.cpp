@@ -0,0 +1,143 @@
+/*
+    Writes images with writeQOI and reads them back with a decoder written
+    from the QOI specification, which must give back every pixel. Returns
+    non-zero and prints the first bad pixel of any image that does not.
+*/
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+#include "../src/ImageWriter.h"
+
+using namespace std;
+
+/* Decodes a QOI file to packed rgb, or returns false if it is malformed */
+static bool readQOI(const string &filename, vector<unsigned char> &rgb, int &width, int &height)
+{
+	ifstream file(filename, ios::binary);
+	vector<unsigned char> data((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+	if(data.size() < 14 + 8 || memcmp(data.data(), "qoif", 4) != 0) {
+		return false;
+	}
+	width = data[4] << 24 | data[5] << 16 | data[6] << 8 | data[7];
+	height = data[8] << 24 | data[9] << 16 | data[10] << 8 | data[11];
+
+	// the decoder state starts as the specification says
+	unsigned char index[64][4] = {};
+	unsigned char px[4] = {0, 0, 0, 255};
+	size_t numPixels = size_t(width) * height;
+	size_t p = 14, end = data.size() - 8;
+	int run = 0;
+	rgb.clear();
+	for(size_t i = 0; i < numPixels; i++) {
+		if(run > 0) {
+			run--;
+		} else {
+			if(p >= end) {
+				return false;
+			}
+			unsigned char op = data[p++];
+			if(op == 0xfe || op == 0xff) {
+				if(p + (op == 0xfe ? 3 : 4) > end) {
+					return false;
+				}
+				memcpy(px, &data[p], op == 0xfe ? 3 : 4);
+				p += op == 0xfe ? 3 : 4;
+			} else if((op & 0xc0) == 0x00) {
+				memcpy(px, index[op], 4);
+			} else if((op & 0xc0) == 0x40) {
+				px[0] += ((op >> 4) & 3) - 2;
+				px[1] += ((op >> 2) & 3) - 2;
+				px[2] += (op & 3) - 2;
+			} else if((op & 0xc0) == 0x80) {
+				if(p >= end) {
+					return false;
+				}
+				int dg = (op & 0x3f) - 32;
+				unsigned char b = data[p++];
+				px[0] += dg + (b >> 4) - 8;
+				px[1] += dg;
+				px[2] += dg + (b & 0x0f) - 8;
+			} else {
+				run = op & 0x3f;
+			}
+			memcpy(index[(px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64], px, 4);
+		}
+		if(px[3] != 255) {
+			return false;
+		}
+		rgb.insert(rgb.end(), px, px + 3);
+	}
+	return p == end && memcmp(&data[end], "\0\0\0\0\0\0\0\1", 8) == 0;
+}
+
+static int roundTrip(const char *name, const vector<unsigned char> &rgb, int width, int height)
+{
+	const string filename = "test_qoi.qoi";
+	vector<unsigned char> decoded;
+	int decodedWidth = 0, decodedHeight = 0;
+	if(writeQOI(filename, rgb.data(), width, height) == 0) {
+		printf("%s: could not write %s\n", name, filename.c_str());
+		return 1;
+	}
+	bool ok = readQOI(filename, decoded, decodedWidth, decodedHeight);
+	remove(filename.c_str());
+	if(!ok || decodedWidth != width || decodedHeight != height) {
+		printf("%s: the file does not decode\n", name);
+		return 1;
+	}
+	for(size_t i = 0; i < rgb.size(); i += 3) {
+		if(memcmp(&rgb[i], &decoded[i], 3) != 0) {
+			printf("%s: pixel %d is (%d, %d, %d), decoded as (%d, %d, %d)\n", name, int(i / 3),
+			       rgb[i], rgb[i + 1], rgb[i + 2], decoded[i], decoded[i + 1], decoded[i + 2]);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+int main()
+{
+	int failed = 0;
+
+	// opaque black hashes to the slot of the empty index entries
+	const unsigned char row[9][3] = {{255, 0, 0}, {0, 0, 0}, {0, 255, 0}, {255, 0, 0}, {0, 0, 0},
+	                                 {0, 255, 0}, {10, 20, 30}, {0, 0, 0}, {10, 20, 30}};
+	failed += roundTrip("black", vector<unsigned char>(&row[0][0], &row[0][0] + sizeof(row)), 9, 1);
+
+	// long runs, including one that ends the image
+	vector<unsigned char> runs(3 * 300, 0);
+	fill(runs.begin() + 3 * 100, runs.begin() + 3 * 200, 200);
+	failed += roundTrip("runs", runs, 20, 15);
+
+	// small steps for the diff and luma ops
+	mt19937 rng(7);
+	vector<unsigned char> gradient(3 * 256 * 64);
+	for(size_t i = 3; i < gradient.size(); i++) {
+		gradient[i] = static_cast<unsigned char>(gradient[i - 3] + rng() % 21 - 10);
+	}
+	failed += roundTrip("gradient", gradient, 256, 64);
+
+	// a few colors and black, so index hits are common
+	const unsigned char palette[5][3] = {{0, 0, 0}, {255, 255, 255}, {12, 34, 56}, {200, 10, 90}, {0, 0, 1}};
+	vector<unsigned char> paletted;
+	for(int i = 0; i < 128 * 128; i++) {
+		const unsigned char *c = palette[rng() % 5];
+		paletted.insert(paletted.end(), c, c + 3);
+	}
+	failed += roundTrip("palette", paletted, 128, 128);
+
+	vector<unsigned char> noise(3 * 97 * 31);
+	for(unsigned char &c : noise) {
+		c = static_cast<unsigned char>(rng());
+	}
+	failed += roundTrip("noise", noise, 97, 31);
+
+	printf("%d of 5 images failed the QOI round trip\n", failed);
+	return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,5 +1,6 @@
 
 #include "Shape.h"
+#include "MeshCache.h"
 #include <iostream>
 #include <cassert>
 
@@ -17,6 +18,18 @@ void Shape::createShape(tinyobj::shape_t &shape)
     eleBuf = shape.mesh.indices;
 }
 
+// copy the data from a cached mesh, whose bounds are already measured
+void Shape::createShape(const CachedMesh &mesh)
+{
+    posBuf.assign(mesh.positions, mesh.positions + mesh.numPositions);
+    norBuf.assign(mesh.normals, mesh.normals + mesh.numNormals);
+    texBuf.assign(mesh.texcoords, mesh.texcoords + mesh.numTexcoords);
+    eleBuf.assign(mesh.indices, mesh.indices + mesh.numIndices);
+
+    min = glm::vec3(mesh.min[0], mesh.min[1], mesh.min[2]);
+    max = glm::vec3(mesh.max[0], mesh.max[1], mesh.max[2]);
+}
+
 void Shape::measure()
 {
     float minX, minY, minZ;
@@ -10,6 +10,7 @@
 #include "GLSL.h"
 #include "Program.h"
 #include "Shape.h"
+#include "MeshCache.h"
 #include "MatrixStack.h"
 #include "WindowManager.h"
 #include "Texture.h"
@@ -276,11 +277,11 @@ public:
         //  Initialize mesh
         //  Load geometry
         //  Some obj files contain material information.We'll ignore them for this assignment.
-        vector<tinyobj::shape_t> TOshapes;
+        MeshCache cache;
         vector<tinyobj::material_t> objMaterials;
         string errStr;
         // load in the mesh and make the shape(s)
-        bool rc = tinyobj::LoadObj(TOshapes, objMaterials, errStr, (resourceDirectory + "/sphereWTex.obj").c_str());
+        bool rc = cache.load(resourceDirectory + "/sphereWTex.obj", objMaterials, errStr);
         if (!rc)
         {
             cerr << errStr << endl;
@@ -288,16 +289,15 @@ public:
         else
         {
             sphere = make_shared<Shape>();
-            sphere->createShape(TOshapes[0]);
-            sphere->measure();
+            sphere->createShape(cache.getShapes()[0]);
             sphere->init();
         }
 
         // Initialize bunny mesh.
-        vector<tinyobj::shape_t> TOshapesB;
+        MeshCache cacheB;
         vector<tinyobj::material_t> objMaterialsB;
         // load in the mesh and make the shape(s)
-        rc = tinyobj::LoadObj(TOshapesB, objMaterialsB, errStr, (resourceDirectory + "/dog.obj").c_str());
+        rc = cacheB.load(resourceDirectory + "/dog.obj", objMaterialsB, errStr);
         if (!rc)
         {
             cerr << errStr << endl;
@@ -305,8 +305,7 @@ public:
         else
         {
             theDog = make_shared<Shape>();
-            theDog->createShape(TOshapesB[0]);
-            theDog->measure();
+            theDog->createShape(cacheB.getShapes()[0]);
             theDog->init();
         }
 
@@ -322,22 +321,21 @@ public:
     vector<shared_ptr<Shape>> loadMultModel(const std::string &filename, const std::string &resourceDirectory)
     {
         vector<shared_ptr<Shape>> model;
-        vector<tinyobj::shape_t> TOshapes;
+        MeshCache cache;
         vector<tinyobj::material_t> objMaterials;
         string errStr;
 
-        bool rc = tinyobj::LoadObj(TOshapes, objMaterials, errStr, (resourceDirectory + filename).c_str());
+        bool rc = cache.load(resourceDirectory + filename, objMaterials, errStr);
         if (!rc)
         {
             cerr << "Failed to load " << filename << ": " << errStr << endl;
             return model;
         }
 
-        for (auto &TOshape : TOshapes)
+        for (const CachedMesh &mesh : cache.getShapes())
         {
             auto shape = make_shared<Shape>();
-            shape->createShape(TOshape);
-            shape->measure();
+            shape->createShape(mesh);
             shape->init();
             model.push_back(shape);
         }